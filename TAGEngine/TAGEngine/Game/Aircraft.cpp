@@ -6,6 +6,7 @@
 #include "SoundNode.hpp"
 #include "ResourceHolder.hpp"
 #include "MyCategory.hpp"
+#include "RenderQueue.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
@@ -183,6 +184,34 @@ void Aircraft::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) co
         target.draw(mSprite, states);
 	}
 }
+
+void Aircraft::recordCurrent(RenderQueue& queue, sf::RenderStates states) const
+{
+    // the explosion frame is cut from its own sheet so it batches with other explosions
+    if(isDestroyed() && mShowExplosion)
+    {
+        states.transform *= mExplosion.getTransform();
+        queue.addSprite(mExplosion.getSprite(), states);
+    }
+    else
+    {
+        queue.addSprite(mSprite, states);
+    }
+}
+
+bool Aircraft::getDrawBounds(const sf::Transform& transform, sf::FloatRect& bounds) const
+{
+    // the explosion is far larger than the aircraft
+    if(isDestroyed() && mShowExplosion)
+    {
+        bounds = transform.transformRect(mExplosion.getGlobalBounds());
+    }
+    else
+    {
+        bounds = transform.transformRect(mSprite.getGlobalBounds());
+    }
+    return true;
+}
 	
 void Aircraft::updateCurrent(sf::Time dt, CommandQueue& commands)
 {
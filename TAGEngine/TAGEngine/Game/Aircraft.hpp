@@ -40,6 +40,8 @@ public:
 	
 private:
     virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
+    virtual void recordCurrent(RenderQueue& queue, sf::RenderStates states) const;
+    virtual bool getDrawBounds(const sf::Transform& transform, sf::FloatRect& bounds) const;
 	virtual void updateCurrent(sf::Time dt, CommandQueue& commands);
 	void updateMovementPattern(sf::Time dt);
 	void checkPickupDrop(CommandQueue& commands);
@@ -3,6 +3,7 @@
 #include "MyCategory.hpp"
 #include "CommandQueue.hpp"
 #include "Utility.hpp"
+#include "RenderQueue.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 
@@ -37,4 +38,9 @@ void Pickup::apply(Aircraft& player) const
 void Pickup::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
 {
     target.draw(mSprite, states);
+}
+
+void Pickup::recordCurrent(RenderQueue& queue, sf::RenderStates states) const
+{
+    queue.addSprite(mSprite, states);
 }
\ No newline at end of file
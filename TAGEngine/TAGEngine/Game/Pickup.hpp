@@ -28,6 +28,7 @@ public:
 
 protected:
     virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
+    virtual void recordCurrent(RenderQueue& queue, sf::RenderStates states) const;
 	
 private:
     Type mType;
@@ -4,6 +4,7 @@
 #include "Utility.hpp"
 #include "ResourceHolder.hpp"
 #include "MyCategory.hpp"
+#include "RenderQueue.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
@@ -77,6 +78,11 @@ void Projectile::drawCurrent(sf::RenderTarget& target, sf::RenderStates states)
     target.draw(mSprite, states);
 }
 
+void Projectile::recordCurrent(RenderQueue& queue, sf::RenderStates states) const
+{
+    queue.addSprite(mSprite, states);
+}
+
 unsigned int Projectile::getCategory() const
 {
     if(mType == EnemyBullet)
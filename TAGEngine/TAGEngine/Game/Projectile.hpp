@@ -29,6 +29,7 @@ public:
 private:
     virtual void updateCurrent(sf::Time dt, CommandQueue& commands);
 	virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
+    virtual void recordCurrent(RenderQueue& queue, sf::RenderStates states) const;
 	
 	Type mType;
 	sf::Sprite mSprite;
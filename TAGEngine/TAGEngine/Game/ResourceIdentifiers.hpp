@@ -37,7 +37,9 @@ namespace Shaders
 	    BrightnessPass,
 		DownSamplePass,
 		GaussianBlurPass,
-		AddPass
+		AddPass,
+		DualDownSamplePass,
+		DualUpSamplePass
 	};
 }
 
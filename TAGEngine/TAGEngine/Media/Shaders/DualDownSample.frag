@@ -0,0 +1,30 @@
+uniform sampler2D 	source;
+uniform vec2 		sourceSize;
+uniform float 		brightPass;
+
+const float Threshold = 0.7;
+const float Factor   = 4.0;
+
+// the first pass of the chain also does the work of Brightness.frag on each sample
+vec4 filteredSample(vec2 textureCoordinates)
+{
+    vec4 color = texture2D(source, textureCoordinates);
+    if(brightPass > 0.5)
+    {
+        float luminance = color.r * 0.2126 + color.g * 0.7152 + color.b * 0.0722;
+        color *= clamp(luminance - Threshold, 0.0, 1.0) * Factor;
+    }
+    return color;
+}
+
+void main()
+{
+    vec2 halfPixel = vec2(0.5 / sourceSize.x, 0.5 / sourceSize.y);
+    vec2 textureCoordinates = gl_TexCoord[0].xy;
+    vec4 color = filteredSample(textureCoordinates) * 4.0;
+    color     += filteredSample(textureCoordinates - halfPixel);
+    color     += filteredSample(textureCoordinates + halfPixel);
+    color     += filteredSample(textureCoordinates + vec2(halfPixel.x, -halfPixel.y));
+    color     += filteredSample(textureCoordinates - vec2(halfPixel.x, -halfPixel.y));
+    gl_FragColor = color / 8.0;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+uniform sampler2D 	source;
+uniform vec2 		sourceSize;
+uniform sampler2D 	base;
+uniform float 		baseFactor;
+
+void main()
+{
+    vec2 halfPixel = vec2(0.5 / sourceSize.x, 0.5 / sourceSize.y);
+    vec2 textureCoordinates = gl_TexCoord[0].xy;
+    vec4 color = texture2D(source, textureCoordinates + vec2(-halfPixel.x * 2.0, 0.0));
+    color     += texture2D(source, textureCoordinates + vec2(-halfPixel.x, halfPixel.y)) * 2.0;
+    color     += texture2D(source, textureCoordinates + vec2(0.0, halfPixel.y * 2.0));
+    color     += texture2D(source, textureCoordinates + vec2(halfPixel.x, halfPixel.y)) * 2.0;
+    color     += texture2D(source, textureCoordinates + vec2(halfPixel.x * 2.0, 0.0));
+    color     += texture2D(source, textureCoordinates + vec2(halfPixel.x, -halfPixel.y)) * 2.0;
+    color     += texture2D(source, textureCoordinates + vec2(0.0, -halfPixel.y * 2.0));
+    color     += texture2D(source, textureCoordinates + vec2(-halfPixel.x, -halfPixel.y)) * 2.0;
+    // the last pass adds the bloom to the scene, as Add.frag does
+    gl_FragColor = color / 12.0 + texture2D(base, textureCoordinates) * baseFactor;
+}
\ No newline at end of file
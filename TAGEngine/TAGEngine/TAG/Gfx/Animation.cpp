@@ -92,6 +92,11 @@ sf::FloatRect Animation::getGlobalBounds() const
 {
     return getTransform().transformRect(getLocalBounds());
 }
+
+const sf::Sprite& Animation::getSprite() const
+{
+    return mSprite;
+}
 	
 void Animation::update(sf::Time dt)
 {
@@ -29,6 +29,8 @@ public:
 	
 	sf::FloatRect getLocalBounds() const;
 	sf::FloatRect getGlobalBounds() const;
+	// the current frame, relative to the animation's own transform
+	const sf::Sprite& getSprite() const;
 	
 	void update(sf::Time dt);
 	
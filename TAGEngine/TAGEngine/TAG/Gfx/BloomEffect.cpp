@@ -2,19 +2,67 @@
 
 #include "ResourcePath.hpp"
 
+#include <algorithm>
+
 BloomEffect::BloomEffect()
  : mShaders()
  , mBrightnessTexture()
  , mFirstPassTextures()
  , mSecondPassTextures()
+ , mDualTextures()
+ , mQuality(High)
+ , mPasses()
+ , mPassClock()
 {
     mShaders.load(Shaders::BrightnessPass, resourcePath() + SHADERS + "Fullpass.vert", resourcePath() + SHADERS + "Brightness.frag");
     mShaders.load(Shaders::DownSamplePass, resourcePath() + SHADERS + "Fullpass.vert", resourcePath() + SHADERS + "DownSample.frag");
     mShaders.load(Shaders::GaussianBlurPass, resourcePath() + SHADERS + "Fullpass.vert", resourcePath() + SHADERS + "GaussianBlur.frag");
     mShaders.load(Shaders::AddPass, resourcePath() + SHADERS + "Fullpass.vert", resourcePath() + SHADERS + "Add.frag");
+    mShaders.load(Shaders::DualDownSamplePass, resourcePath() + SHADERS + "Fullpass.vert", resourcePath() + SHADERS + "DualDownSample.frag");
+    mShaders.load(Shaders::DualUpSamplePass, resourcePath() + SHADERS + "Fullpass.vert", resourcePath() + SHADERS + "DualUpSample.frag");
 }
 
 void BloomEffect::apply(const sf::RenderTexture& input, sf::RenderTarget& output)
+{
+    mPasses.clear();
+    mPassClock.restart();
+    
+    switch(mQuality)
+    {
+        case Low:
+            applyDualFilter(input, output, 3);
+            break;
+        case Medium:
+            applyDualFilter(input, output, 4);
+            break;
+        case High:
+        default:
+            applyGaussian(input, output);
+            break;
+    }
+}
+
+void BloomEffect::setQuality(Quality quality)
+{
+    mQuality = quality;
+}
+
+BloomEffect::Quality BloomEffect::getQuality() const
+{
+    return mQuality;
+}
+
+const std::vector<BloomEffect::Pass>& BloomEffect::getPasses() const
+{
+    return mPasses;
+}
+
+std::size_t BloomEffect::getPassCount() const
+{
+    return mPasses.size();
+}
+
+void BloomEffect::applyGaussian(const sf::RenderTexture& input, sf::RenderTarget& output)
 {
     prepareTextures(input.getSize());
 	
@@ -31,6 +79,50 @@ void BloomEffect::apply(const sf::RenderTexture& input, sf::RenderTarget& output
 	add(input, mFirstPassTextures[1], output);
 }
 
+void BloomEffect::applyDualFilter(const sf::RenderTexture& input, sf::RenderTarget& output, std::size_t levels)
+{
+    prepareDualTextures(input.getSize(), levels);
+	
+	sf::Shader& downSampler = mShaders.get(Shaders::DualDownSamplePass);
+	sf::Shader& upSampler = mShaders.get(Shaders::DualUpSamplePass);
+	
+	// the first pass filters the bright parts of the input as it down samples
+	const sf::RenderTexture* source = &input;
+	for(std::size_t i = 0; i < mDualTextures.size(); ++i)
+	{
+	    sf::RenderTexture& target = *mDualTextures[i];
+		
+		downSampler.setParameter("source", source->getTexture());
+		downSampler.setParameter("sourceSize", sf::Vector2f(source->getSize()));
+		downSampler.setParameter("brightPass", i == 0 ? 1.f : 0.f);
+		applyShader(downSampler, target);
+		target.display();
+		endPass("dual down sample");
+		
+		source = &target;
+	}
+	
+	// each level is only read by the pass above it, so up sampling can write back over them
+	upSampler.setParameter("baseFactor", 0.f);
+	for(std::size_t i = mDualTextures.size() - 1; i > 0; --i)
+	{
+	    upSampler.setParameter("source", mDualTextures[i]->getTexture());
+		upSampler.setParameter("sourceSize", sf::Vector2f(mDualTextures[i]->getSize()));
+		upSampler.setParameter("base", mDualTextures[i]->getTexture());
+		applyShader(upSampler, *mDualTextures[i - 1]);
+		mDualTextures[i - 1]->display();
+		endPass("dual up sample");
+	}
+	
+	// the last up sample adds the bloom to the input on its way to the output
+	upSampler.setParameter("source", mDualTextures[0]->getTexture());
+	upSampler.setParameter("sourceSize", sf::Vector2f(mDualTextures[0]->getSize()));
+	upSampler.setParameter("base", input.getTexture());
+	upSampler.setParameter("baseFactor", 1.f);
+	applyShader(upSampler, output);
+	endPass("dual up sample and add");
+}
+
 void BloomEffect::prepareTextures(sf::Vector2u size)
 {
     if(mBrightnessTexture.getSize() != size)
@@ -50,6 +142,30 @@ void BloomEffect::prepareTextures(sf::Vector2u size)
 	}
 }
 
+void BloomEffect::prepareDualTextures(sf::Vector2u size, std::size_t levels)
+{
+    if(mDualTextures.size() == levels && mDualTextures[0]->getSize() == sf::Vector2u(std::max(size.x / 2, 1u), std::max(size.y / 2, 1u)))
+		return;
+	
+	mDualTextures.clear();
+	for(std::size_t i = 0; i < levels; ++i)
+	{
+	    size.x = std::max(size.x / 2, 1u);
+		size.y = std::max(size.y / 2, 1u);
+		
+		std::unique_ptr<sf::RenderTexture> texture(new sf::RenderTexture());
+		texture->create(size.x, size.y);
+		texture->setSmooth(true);
+		mDualTextures.push_back(std::move(texture));
+	}
+}
+
+void BloomEffect::endPass(const char* name)
+{
+    Pass pass = { name, mPassClock.restart() };
+	mPasses.push_back(pass);
+}
+
 void BloomEffect::filterBright(const sf::RenderTexture& input, sf::RenderTexture& output)
 {
     sf::Shader& brightness = mShaders.get(Shaders::BrightnessPass);
@@ -57,6 +173,7 @@ void BloomEffect::filterBright(const sf::RenderTexture& input, sf::RenderTexture
 	brightness.setParameter("source", input.getTexture());
 	applyShader(brightness, output);
 	output.display();
+	endPass("brightness");
 }
 
 void BloomEffect::blurMultipass(RenderTextureArray& renderTextures)
@@ -78,6 +195,7 @@ void BloomEffect::blur(const sf::RenderTexture& input, sf::RenderTexture& output
 	gaussianBlur.setParameter("offsetFactor", offsetFactor);
 	applyShader(gaussianBlur, output);
 	output.display();
+	endPass("gaussian blur");
 }
 
 void BloomEffect::downSample(const sf::RenderTexture& input, sf::RenderTexture& output)
@@ -88,6 +206,7 @@ void BloomEffect::downSample(const sf::RenderTexture& input, sf::RenderTexture&
 	downSampler.setParameter("sourceSize", sf::Vector2f(input.getSize()));
 	applyShader(downSampler, output);
 	output.display();
+	endPass("down sample");
 }
 
 void BloomEffect::add(const sf::RenderTexture& source, sf::RenderTexture& bloom, sf::RenderTarget& target)
@@ -97,4 +216,5 @@ void BloomEffect::add(const sf::RenderTexture& source, sf::RenderTexture& bloom,
 	adder.setParameter("source", source.getTexture());
 	adder.setParameter("bloom", bloom.getTexture());
 	applyShader(adder, target);
+	endPass("add");
 }
\ No newline at end of file
@@ -6,19 +6,47 @@
 
 #include <SFML/Graphics/RenderTexture.hpp>
 #include <SFML/Graphics/Shader.hpp>
+#include <SFML/System/Clock.hpp>
 
 #include <array>
+#include <memory>
+#include <vector>
 
 class BloomEffect : public PostEffect
 {
 public:
+    enum Quality
+    {
+        Low,    // dual filter blur over three levels, 6 passes
+        Medium, // dual filter blur over four levels, 8 passes
+        High    // gaussian blur at half and quarter resolution, 13 passes
+    };
+    
+    struct Pass
+    {
+        const char* name;
+        sf::Time time;
+    };
+    
     BloomEffect();
 	virtual void apply(const sf::RenderTexture& input, sf::RenderTarget& output);
 	
+	void setQuality(Quality quality);
+	Quality getQuality() const;
+	
+	// the passes run by the last apply and the cpu time each took to issue. The gpu runs them
+	// asynchronously, so a pass only shows its gpu cost when it has to wait for an earlier one.
+	const std::vector<Pass>& getPasses() const;
+	std::size_t getPassCount() const;
+	
 private:
     typedef std::array<sf::RenderTexture, 2> RenderTextureArray;
 	
+	void applyGaussian(const sf::RenderTexture& input, sf::RenderTarget& output);
+	void applyDualFilter(const sf::RenderTexture& input, sf::RenderTarget& output, std::size_t levels);
 	void prepareTextures(sf::Vector2u size);
+	void prepareDualTextures(sf::Vector2u size, std::size_t levels);
+	void endPass(const char* name);
 	
 	void filterBright(const sf::RenderTexture& input, sf::RenderTexture& output);
 	void blurMultipass(RenderTextureArray& renderTextures);
@@ -31,4 +59,10 @@ private:
 	sf::RenderTexture mBrightnessTexture;
 	RenderTextureArray mFirstPassTextures;
 	RenderTextureArray mSecondPassTextures;
+	// each level half the size of the one before, starting at half the input size
+	std::vector<std::unique_ptr<sf::RenderTexture>> mDualTextures;
+	
+	Quality mQuality;
+	std::vector<Pass> mPasses;
+	sf::Clock mPassClock;
 };
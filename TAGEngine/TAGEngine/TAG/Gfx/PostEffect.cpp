@@ -2,7 +2,14 @@
 
 #include <SFML/Graphics/Shader.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
-#include <SFML/Graphics/VertexArray.hpp>
+
+PostEffect::PostEffect()
+{
+    mQuad[0] = sf::Vertex(sf::Vector2f(0.f, 0.f), sf::Vector2f(0.f, 1.f));
+    mQuad[1] = sf::Vertex(sf::Vector2f(1.f, 0.f), sf::Vector2f(1.f, 1.f));
+    mQuad[2] = sf::Vertex(sf::Vector2f(0.f, 1.f), sf::Vector2f(0.f, 0.f));
+    mQuad[3] = sf::Vertex(sf::Vector2f(1.f, 1.f), sf::Vector2f(1.f, 0.f));
+}
 
 PostEffect::~PostEffect()
 {}
@@ -11,17 +18,12 @@ void PostEffect::applyShader(const sf::Shader& shader, sf::RenderTarget& output)
 {
     sf::Vector2f outputSize = static_cast<sf::Vector2f>(output.getSize());
 	
-	sf::VertexArray vertices(sf::TrianglesStrip, 4);
-	vertices[0] = sf::Vertex(sf::Vector2f(0,0),             sf::Vector2f(0, 1));
-	vertices[1] = sf::Vertex(sf::Vector2f(outputSize.x, 0), sf::Vector2f(1, 1));
-	vertices[2] = sf::Vertex(sf::Vector2f(0, outputSize.y), sf::Vector2f(0, 0));
-	vertices[3] = sf::Vertex(sf::Vector2f(outputSize),      sf::Vector2f(1, 0));
-	
 	sf::RenderStates states;
+	states.transform.scale(outputSize);
 	states.shader = &shader;
 	states.blendMode = sf::BlendNone;
 	
-	output.draw(vertices, states);
+	output.draw(mQuad, 4, sf::TrianglesStrip, states);
 }
 
 bool PostEffect::isSupported()
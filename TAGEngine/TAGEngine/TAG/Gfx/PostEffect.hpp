@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SFML/System/NonCopyable.hpp>
+#include <SFML/Graphics/Vertex.hpp>
 
 namespace sf
 {
@@ -15,11 +16,16 @@ namespace sf
 class PostEffect : sf::NonCopyable
 {
 public:
+    PostEffect();
     virtual ~PostEffect();
 	virtual void apply(const sf::RenderTexture& input, sf::RenderTarget& output) = 0;
 	
 	static bool isSupported();
 
 protected:
-    static void applyShader(const sf::Shader& shader, sf::RenderTarget& output);
+    void applyShader(const sf::Shader& shader, sf::RenderTarget& output);
+    
+private:
+    // unit quad, scaled to the size of the output when drawn
+    sf::Vertex mQuad[4];
 };
\ No newline at end of file
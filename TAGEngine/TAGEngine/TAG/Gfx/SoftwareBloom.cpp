@@ -0,0 +1,464 @@
+#include "SoftwareBloom.hpp"
+
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // same constants as Brightness.frag and GaussianBlur.frag
+    const float Threshold = 0.7f;
+    const float Factor = 4.f;
+    const float GaussianWeights[9] =
+    {
+        0.0162162162f, 0.0540540541f, 0.1216216216f, 0.1945945946f, 0.2270270270f,
+        0.1945945946f, 0.1216216216f, 0.0540540541f, 0.0162162162f
+    };
+
+    // passes over fewer rows than this per thread aren't worth starting threads for
+    const sf::Uint32 MinRowsPerThread = 16u;
+
+    sf::Uint32 clampIndex(int index, sf::Uint32 size)
+    {
+        return static_cast<sf::Uint32>(std::min(std::max(index, 0), static_cast<int>(size) - 1));
+    }
+
+    // a linear sample at u, in texels of the input, from a smooth texture clamped at its edges
+    void addLinearSample(SoftwareBloom::Filter& filter, float u, sf::Uint32 inputSize, float weight)
+    {
+        u -= 0.5f;
+        const float base = std::floor(u);
+        const float fraction = u - base;
+
+        filter.indices.push_back(clampIndex(static_cast<int>(base), inputSize));
+        filter.weights.push_back((1.f - fraction) * weight);
+        filter.indices.push_back(clampIndex(static_cast<int>(base) + 1, inputSize));
+        filter.weights.push_back(fraction * weight);
+    }
+
+    // DownSample.frag averages nine linear samples a texel apart. Each is separable so the
+    // average is three samples along x times three along y.
+    void createDownSample(SoftwareBloom::Filter& filter, sf::Uint32 inputSize, sf::Uint32 outputSize)
+    {
+        filter.taps = 6u;
+        filter.indices.clear();
+        filter.weights.clear();
+
+        const float scale = static_cast<float>(inputSize) / outputSize;
+        for(sf::Uint32 i = 0u; i < outputSize; ++i)
+        {
+            const float centre = (i + 0.5f) * scale;
+            for(int offset = -1; offset <= 1; ++offset)
+                addLinearSample(filter, centre + offset, inputSize, 1.f / 3.f);
+        }
+    }
+
+    // GaussianBlur.frag samples texel centres so no linear filtering is involved
+    void createBlur(SoftwareBloom::Filter& filter, sf::Uint32 size)
+    {
+        filter.taps = 9u;
+        filter.indices.clear();
+        filter.weights.clear();
+
+        for(sf::Uint32 i = 0u; i < size; ++i)
+        {
+            for(int tap = 0; tap < 9; ++tap)
+            {
+                filter.indices.push_back(clampIndex(static_cast<int>(i) + tap - 4, size));
+                filter.weights.push_back(GaussianWeights[tap]);
+            }
+        }
+    }
+
+    // Add.frag samples the smaller bloom texture at the centre of each output texel
+    void createUpSample(SoftwareBloom::Filter& filter, sf::Uint32 inputSize, sf::Uint32 outputSize)
+    {
+        filter.taps = 2u;
+        filter.indices.clear();
+        filter.weights.clear();
+
+        const float scale = static_cast<float>(inputSize) / outputSize;
+        for(sf::Uint32 i = 0u; i < outputSize; ++i)
+            addLinearSample(filter, (i + 0.5f) * scale, inputSize, 1.f);
+    }
+
+    inline float load(sf::Uint8 value)
+    {
+        return value;
+    }
+
+    inline float load(float value)
+    {
+        return value;
+    }
+
+    inline void store(float value, float& dest)
+    {
+        dest = value;
+    }
+
+    // rounds the way a write to an 8 bit render texture does
+    inline void store(float value, sf::Uint8& dest)
+    {
+        dest = static_cast<sf::Uint8>(std::min(std::max(value, 0.f), 255.f) + 0.5f);
+    }
+
+    // filters rows [begin, end) of input along x
+    template <typename In, typename Out>
+    void filterRows(const In* input, sf::Uint32 inputWidth, const SoftwareBloom::Filter& filter, Out* output, sf::Uint32 begin, sf::Uint32 end)
+    {
+        const sf::Uint32 outputWidth = filter.indices.size() / filter.taps;
+        for(sf::Uint32 y = begin; y < end; ++y)
+        {
+            const In* row = input + y * inputWidth * 4u;
+            Out* dest = output + y * outputWidth * 4u;
+
+            for(sf::Uint32 x = 0u; x < outputWidth; ++x)
+            {
+                const sf::Uint32* indices = &filter.indices[x * filter.taps];
+                const float* weights = &filter.weights[x * filter.taps];
+
+                float colour[4] = { 0.f, 0.f, 0.f, 0.f };
+                for(sf::Uint32 tap = 0u; tap < filter.taps; ++tap)
+                {
+                    const In* texel = row + indices[tap] * 4u;
+                    for(int c = 0; c < 4; ++c)
+                        colour[c] += weights[tap] * load(texel[c]);
+                }
+
+                for(int c = 0; c < 4; ++c)
+                    store(colour[c], dest[x * 4u + c]);
+            }
+        }
+    }
+
+    // filters output rows [begin, end) along y. Whole input rows are accumulated at once into row,
+    // the scratch row of the calling thread, so the inner loop runs over contiguous texels, which the
+    // compiler can vectorise.
+    template <typename In, typename Out>
+    void filterColumns(const In* input, sf::Uint32 width, const SoftwareBloom::Filter& filter, Out* output, sf::Uint32 begin, sf::Uint32 end, std::vector<float>& row)
+    {
+        const sf::Uint32 count = width * 4u;
+        row.resize(count);
+
+        for(sf::Uint32 y = begin; y < end; ++y)
+        {
+            const sf::Uint32* indices = &filter.indices[y * filter.taps];
+            const float* weights = &filter.weights[y * filter.taps];
+
+            std::fill(row.begin(), row.end(), 0.f);
+            for(sf::Uint32 tap = 0u; tap < filter.taps; ++tap)
+            {
+                const In* source = input + indices[tap] * count;
+                const float weight = weights[tap];
+                for(sf::Uint32 i = 0u; i < count; ++i)
+                    row[i] += weight * load(source[i]);
+            }
+
+            Out* dest = output + y * count;
+            for(sf::Uint32 i = 0u; i < count; ++i)
+                store(row[i], dest[i]);
+        }
+    }
+
+}
+
+SoftwareBloom::SoftwareBloom(unsigned int threadCount)
+ : mThreadCount(1u)
+ , mTask(nullptr)
+ , mTaskCount(0u)
+ , mTaskStep(0u)
+ , mTaskGeneration(0u)
+ , mPending(0u)
+ , mStopping(false)
+{
+    setThreadCount(threadCount);
+}
+
+SoftwareBloom::~SoftwareBloom()
+{
+    stopWorkers();
+}
+
+void SoftwareBloom::apply(const sf::RenderTexture& input, sf::RenderTarget& output)
+{
+    mInputImage = input.getTexture().copyToImage();
+    apply(mInputImage, mOutputImage);
+
+    const sf::Vector2u size = mOutputImage.getSize();
+    if(mOutputTexture.getSize() != size) mOutputTexture.create(size.x, size.y);
+    mOutputTexture.update(mOutputImage);
+
+    // covers the output the same way PostEffect::applyShader does
+    sf::Sprite sprite(mOutputTexture);
+    const sf::Vector2f outputSize = static_cast<sf::Vector2f>(output.getSize());
+    sprite.setScale(outputSize.x / size.x, outputSize.y / size.y);
+
+    sf::RenderStates states;
+    states.blendMode = sf::BlendNone;
+    output.draw(sprite, states);
+}
+
+void SoftwareBloom::apply(const sf::Image& input, sf::Image& output)
+{
+    const sf::Vector2u size = input.getSize();
+    mOutputTexels.resize(size.x * size.y * 4u);
+
+    apply(input.getPixelsPtr(), size, mOutputTexels.data());
+    output.create(size.x, size.y, mOutputTexels.data());
+}
+
+void SoftwareBloom::apply(const sf::Uint8* input, sf::Vector2u size, sf::Uint8* output)
+{
+    // too small to have a quarter resolution pass, there is nothing to bloom
+    if(size.x < 4u || size.y < 4u)
+    {
+        std::memcpy(output, input, size.x * size.y * 4u);
+        return;
+    }
+
+    prepareBuffers(size);
+
+    filterBright(input, mBrightness);
+
+    downSample(mBrightness, mFirstPass[0], 0u);
+    blurMultipass(mFirstPass, 0u);
+
+    downSample(mFirstPass[0], mSecondPass[0], 1u);
+    blurMultipass(mSecondPass, 1u);
+
+    add(mFirstPass[0].texels.data(), mFirstPass[0].size, mSecondPass[0], mFirstPass[1].texels.data(), 0u);
+    add(input, size, mFirstPass[1], output, 1u);
+}
+
+void SoftwareBloom::setThreadCount(unsigned int threadCount)
+{
+    if(threadCount == 0u) threadCount = std::thread::hardware_concurrency();
+    threadCount = std::max(1u, threadCount);
+    if(threadCount == mThreadCount && mWorkers.size() + 1u == mThreadCount) return;
+
+    stopWorkers();
+    mThreadCount = threadCount;
+    startWorkers();
+}
+
+unsigned int SoftwareBloom::getThreadCount() const
+{
+    return mThreadCount;
+}
+
+void SoftwareBloom::parallelFor(sf::Uint32 count, const Task& task)
+{
+    const unsigned int threadCount = std::max(1u, std::min<unsigned int>(mThreadCount, count / MinRowsPerThread));
+    if(threadCount == 1u)
+    {
+        task(0u, count, mScratch);
+        return;
+    }
+
+    const sf::Uint32 step = (count + threadCount - 1u) / threadCount;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &task;
+        mTaskCount = count;
+        mTaskStep = step;
+        mPending = (count + step - 1u) / step - 1u;
+        ++mTaskGeneration;
+    }
+    mTaskReady.notify_all();
+
+    // the calling thread takes the first range rather than waiting idle
+    task(0u, std::min(step, count), mScratch);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTaskDone.wait(lock, [this]() { return mPending == 0u; });
+    mTask = nullptr;
+}
+
+void SoftwareBloom::startWorkers()
+{
+    // workers are started between tasks, so each one begins waiting for the next generation
+    for(unsigned int i = 1u; i < mThreadCount; ++i)
+    {
+        mWorkers.emplace_back(new Worker());
+        Worker& worker = *mWorkers.back();
+        worker.thread = std::thread(&SoftwareBloom::runWorker, this, i - 1u, mTaskGeneration, std::ref(worker.scratch));
+    }
+}
+
+void SoftwareBloom::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mTaskReady.notify_all();
+
+    for(auto& worker : mWorkers)
+        worker->thread.join();
+    mWorkers.clear();
+    mStopping = false;
+}
+
+void SoftwareBloom::runWorker(unsigned int index, sf::Uint64 generation, std::vector<float>& scratch)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while(true)
+    {
+        mTaskReady.wait(lock, [this, generation]() { return mStopping || mTaskGeneration != generation; });
+        if(mStopping) return;
+        generation = mTaskGeneration;
+
+        // worker i runs range i + 1, tasks with fewer ranges than threads leave the last workers idle
+        const sf::Uint32 begin = (index + 1u) * mTaskStep;
+        if(begin >= mTaskCount) continue;
+        const sf::Uint32 end = std::min(begin + mTaskStep, mTaskCount);
+        const Task& task = *mTask;
+
+        lock.unlock();
+        task(begin, end, scratch);
+        lock.lock();
+
+        if(--mPending == 0u) mTaskDone.notify_one();
+    }
+}
+
+void SoftwareBloom::prepareBuffers(sf::Vector2u size)
+{
+    if(mBrightness.size == size) return;
+
+    const sf::Vector2u half(size.x / 2u, size.y / 2u);
+    const sf::Vector2u quarter(size.x / 4u, size.y / 4u);
+
+    mBrightness.size = size;
+    mBrightness.texels.resize(size.x * size.y * 4u);
+    for(auto& buffer : mFirstPass)
+    {
+        buffer.size = half;
+        buffer.texels.resize(half.x * half.y * 4u);
+    }
+    for(auto& buffer : mSecondPass)
+    {
+        buffer.size = quarter;
+        buffer.texels.resize(quarter.x * quarter.y * 4u);
+    }
+
+    createDownSample(mDownSampleX[0], size.x, half.x);
+    createDownSample(mDownSampleY[0], size.y, half.y);
+    createDownSample(mDownSampleX[1], half.x, quarter.x);
+    createDownSample(mDownSampleY[1], half.y, quarter.y);
+
+    createBlur(mBlurX[0], half.x);
+    createBlur(mBlurY[0], half.y);
+    createBlur(mBlurX[1], quarter.x);
+    createBlur(mBlurY[1], quarter.y);
+
+    createUpSample(mUpSampleX[0], quarter.x, half.x);
+    createUpSample(mUpSampleY[0], quarter.y, half.y);
+    createUpSample(mUpSampleX[1], half.x, size.x);
+    createUpSample(mUpSampleY[1], half.y, size.y);
+}
+
+void SoftwareBloom::filterBright(const sf::Uint8* input, Buffer& output)
+{
+    const sf::Uint32 width = output.size.x;
+    sf::Uint8* dest = output.texels.data();
+
+    parallelFor(output.size.y, [=](sf::Uint32 begin, sf::Uint32 end, std::vector<float>&)
+    {
+        for(sf::Uint32 i = begin * width * 4u; i < end * width * 4u; i += 4u)
+        {
+            const float luminance = (input[i] * 0.2126f + input[i + 1] * 0.7152f + input[i + 2] * 0.0722f) / 255.f;
+            const float factor = std::min(std::max(luminance - Threshold, 0.f), 1.f) * Factor;
+            for(int c = 0; c < 4; ++c)
+                store(input[i + c] * factor, dest[i + c]);
+        }
+    });
+}
+
+void SoftwareBloom::blurMultipass(Buffer (&buffers)[2], unsigned int pass)
+{
+    for(std::size_t count = 0; count < 2; ++count)
+    {
+        blur(buffers[0], buffers[1], pass, true);
+        blur(buffers[1], buffers[0], pass, false);
+    }
+}
+
+void SoftwareBloom::blur(const Buffer& input, Buffer& output, unsigned int pass, bool vertical)
+{
+    const sf::Uint8* source = input.texels.data();
+    sf::Uint8* dest = output.texels.data();
+    const sf::Uint32 width = input.size.x;
+
+    if(vertical)
+    {
+        const Filter& filter = mBlurY[pass];
+        parallelFor(output.size.y, [=, &filter](sf::Uint32 begin, sf::Uint32 end, std::vector<float>& scratch)
+        {
+            filterColumns(source, width, filter, dest, begin, end, scratch);
+        });
+    }
+    else
+    {
+        const Filter& filter = mBlurX[pass];
+        parallelFor(output.size.y, [=, &filter](sf::Uint32 begin, sf::Uint32 end, std::vector<float>&)
+        {
+            filterRows(source, width, filter, dest, begin, end);
+        });
+    }
+}
+
+void SoftwareBloom::downSample(const Buffer& input, Buffer& output, unsigned int pass)
+{
+    // along x into a float buffer at full height, then along y, so only the final result is rounded
+    mRows.resize(output.size.x * input.size.y * 4u);
+
+    const sf::Uint8* source = input.texels.data();
+    float* rows = mRows.data();
+    sf::Uint8* dest = output.texels.data();
+    const sf::Uint32 inputWidth = input.size.x;
+    const sf::Uint32 outputWidth = output.size.x;
+    const Filter& filterX = mDownSampleX[pass];
+    const Filter& filterY = mDownSampleY[pass];
+
+    parallelFor(input.size.y, [=, &filterX](sf::Uint32 begin, sf::Uint32 end, std::vector<float>&)
+    {
+        filterRows(source, inputWidth, filterX, rows, begin, end);
+    });
+    parallelFor(output.size.y, [=, &filterY](sf::Uint32 begin, sf::Uint32 end, std::vector<float>& scratch)
+    {
+        filterColumns(rows, outputWidth, filterY, dest, begin, end, scratch);
+    });
+}
+
+void SoftwareBloom::add(const sf::Uint8* source, sf::Vector2u sourceSize, const Buffer& bloom, sf::Uint8* output, unsigned int pass)
+{
+    mRows.resize(sourceSize.x * bloom.size.y * 4u);
+    mUpSampled.resize(sourceSize.x * sourceSize.y * 4u);
+
+    const sf::Uint8* bloomTexels = bloom.texels.data();
+    float* rows = mRows.data();
+    float* upSampled = mUpSampled.data();
+    const sf::Uint32 bloomWidth = bloom.size.x;
+    const sf::Uint32 width = sourceSize.x;
+    const Filter& filterX = mUpSampleX[pass];
+    const Filter& filterY = mUpSampleY[pass];
+
+    parallelFor(bloom.size.y, [=, &filterX](sf::Uint32 begin, sf::Uint32 end, std::vector<float>&)
+    {
+        filterRows(bloomTexels, bloomWidth, filterX, rows, begin, end);
+    });
+    parallelFor(sourceSize.y, [=, &filterY](sf::Uint32 begin, sf::Uint32 end, std::vector<float>& scratch)
+    {
+        filterColumns(rows, width, filterY, upSampled, begin, end, scratch);
+
+        // the source is sampled at its own size, so each sample is exactly one texel
+        for(sf::Uint32 i = begin * width * 4u; i < end * width * 4u; ++i)
+            store(load(source[i]) + upSampled[i], output[i]);
+    });
+}
\ No newline at end of file
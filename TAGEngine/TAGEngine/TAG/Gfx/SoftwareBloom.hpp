@@ -0,0 +1,107 @@
+#pragma once
+
+#include "PostEffect.hpp"
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// BloomEffect's passes run on the CPU over RGBA buffers, for machines without shader support
+// and as a reference to check the shader path against. Each pass samples the way its shader
+// does from a smooth, edge clamped render texture and rounds to 8 bits where the shader path
+// writes to a render texture, so the two agree to within the rounding of the GPU.
+class SoftwareBloom : public PostEffect
+{
+public:
+    // one dimension of a separable filter, taps per output texel into the input
+    struct Filter
+    {
+        sf::Uint32 taps;
+        std::vector<sf::Uint32> indices;
+        std::vector<float> weights;
+    };
+
+    // threadCount of 0 uses one thread per core
+    explicit SoftwareBloom(unsigned int threadCount = 0);
+    ~SoftwareBloom();
+
+    virtual void apply(const sf::RenderTexture& input, sf::RenderTarget& output);
+    void apply(const sf::Image& input, sf::Image& output);
+    // input and output are size.x * size.y RGBA texels, and may not overlap
+    void apply(const sf::Uint8* input, sf::Vector2u size, sf::Uint8* output);
+
+    void setThreadCount(unsigned int threadCount);
+    unsigned int getThreadCount() const;
+
+private:
+    struct Buffer
+    {
+        sf::Vector2u size;
+        std::vector<sf::Uint8> texels;
+    };
+
+    // called with a range of rows [begin, end) and the scratch row of the thread running it
+    typedef std::function<void(sf::Uint32, sf::Uint32, std::vector<float>&)> Task;
+
+    // a thread of the pool, kept for the life of the effect along with its scratch row
+    struct Worker
+    {
+        std::thread thread;
+        std::vector<float> scratch;
+    };
+
+    // calls task with contiguous ranges covering [0, count), one range per thread
+    void parallelFor(sf::Uint32 count, const Task& task);
+    void startWorkers();
+    void stopWorkers();
+    void runWorker(unsigned int index, sf::Uint64 generation, std::vector<float>& scratch);
+
+    void prepareBuffers(sf::Vector2u size);
+
+    // pass is 0 at half and 1 at quarter resolution, picking the filters to use
+    void filterBright(const sf::Uint8* input, Buffer& output);
+    void blurMultipass(Buffer (&buffers)[2], unsigned int pass);
+    void blur(const Buffer& input, Buffer& output, unsigned int pass, bool vertical);
+    void downSample(const Buffer& input, Buffer& output, unsigned int pass);
+    void add(const sf::Uint8* source, sf::Vector2u sourceSize, const Buffer& bloom, sf::Uint8* output, unsigned int pass);
+
+    unsigned int mThreadCount;
+
+    // the calling thread runs the first range of each task, the workers the rest
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<float> mScratch;
+    std::mutex mMutex;
+    std::condition_variable mTaskReady;
+    std::condition_variable mTaskDone;
+    const Task* mTask;
+    sf::Uint32 mTaskCount;
+    sf::Uint32 mTaskStep;
+    sf::Uint64 mTaskGeneration; // bumped for each task so workers know they have a new one
+    unsigned int mPending; // workers still running the current task
+    bool mStopping;
+
+    Buffer mBrightness;
+    Buffer mFirstPass[2];
+    Buffer mSecondPass[2];
+    std::vector<float> mRows;
+    std::vector<float> mUpSampled;
+
+    // filters only depend on sizes so are rebuilt with the buffers
+    Filter mDownSampleX[2];
+    Filter mDownSampleY[2];
+    Filter mBlurX[2];
+    Filter mBlurY[2];
+    Filter mUpSampleX[2];
+    Filter mUpSampleY[2];
+
+    sf::Image mInputImage;
+    sf::Image mOutputImage;
+    std::vector<sf::Uint8> mOutputTexels;
+    sf::Texture mOutputTexture;
+};
\ No newline at end of file
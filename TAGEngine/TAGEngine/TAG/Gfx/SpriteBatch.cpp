@@ -0,0 +1,112 @@
+#include "SpriteBatch.hpp"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include <cmath>
+
+namespace
+{
+    void setQuad(const sf::IntRect& textureRect, const sf::Color& color, sf::Vertex* quad)
+    {
+        const float width = static_cast<float>(std::abs(textureRect.width));
+        const float height = static_cast<float>(std::abs(textureRect.height));
+
+        const float left = static_cast<float>(textureRect.left);
+        const float right = left + textureRect.width;
+        const float top = static_cast<float>(textureRect.top);
+        const float bottom = top + textureRect.height;
+
+        quad[0] = sf::Vertex(sf::Vector2f(0.f, 0.f), color, sf::Vector2f(left, top));
+        quad[1] = sf::Vertex(sf::Vector2f(width, 0.f), color, sf::Vector2f(right, top));
+        quad[2] = sf::Vertex(sf::Vector2f(width, height), color, sf::Vector2f(right, bottom));
+        quad[3] = sf::Vertex(sf::Vector2f(0.f, height), color, sf::Vector2f(left, bottom));
+    }
+}
+
+SpriteBatch::SpriteBatch()
+ : mTexture(nullptr)
+ , mVertices()
+{}
+
+SpriteBatch::SpriteBatch(const sf::Texture& texture)
+ : mTexture(&texture)
+ , mVertices()
+{}
+
+void SpriteBatch::setTexture(const sf::Texture* texture)
+{
+    mTexture = texture;
+}
+
+const sf::Texture* SpriteBatch::getTexture() const
+{
+    return mTexture;
+}
+
+void SpriteBatch::clear()
+{
+    mVertices.clear();
+}
+
+void SpriteBatch::reserve(std::size_t quads)
+{
+    mVertices.reserve(quads * 4u);
+}
+
+void SpriteBatch::add(sf::Vector2f position, float rotation, const sf::IntRect& textureRect, const sf::Color& color,
+                      sf::Vector2f origin, sf::Vector2f scale)
+{
+    // same order sf::Transformable applies its components in
+    sf::Transform transform;
+    transform.translate(position);
+    transform.rotate(rotation);
+    transform.scale(scale);
+    transform.translate(-origin);
+
+    addQuad(transform, textureRect, color);
+}
+
+bool SpriteBatch::add(const sf::Sprite& sprite, const sf::Transform& transform)
+{
+    if(sprite.getTexture() != mTexture) return false;
+
+    addQuad(transform * sprite.getTransform(), sprite.getTextureRect(), sprite.getColor());
+    return true;
+}
+
+void SpriteBatch::add(const sf::Vertex* vertices, std::size_t count)
+{
+    mVertices.insert(mVertices.end(), vertices, vertices + count);
+}
+
+std::size_t SpriteBatch::getQuadCount() const
+{
+    return mVertices.size() / 4u;
+}
+
+void SpriteBatch::getQuad(const sf::Sprite& sprite, sf::Vertex* quad)
+{
+    setQuad(sprite.getTextureRect(), sprite.getColor(), quad);
+}
+
+void SpriteBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    if(mVertices.empty()) return;
+
+    states.texture = mTexture;
+    target.draw(mVertices.data(), mVertices.size(), sf::Quads, states);
+}
+
+void SpriteBatch::addQuad(const sf::Transform& transform, const sf::IntRect& textureRect, const sf::Color& color)
+{
+    sf::Vertex quad[4];
+    setQuad(textureRect, color, quad);
+
+    for(auto& vertex : quad)
+    {
+        vertex.position = transform.transformPoint(vertex.position);
+        mVertices.push_back(vertex);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Transform.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <vector>
+
+namespace sf
+{
+    class Sprite;
+    class Texture;
+}
+
+// Accumulates textured quads which share one texture, such as sprites cut from an atlas, and
+// draws them all with a single draw call.
+class SpriteBatch : public sf::Drawable, private sf::NonCopyable
+{
+public:
+    SpriteBatch();
+    explicit SpriteBatch(const sf::Texture& texture);
+
+    void setTexture(const sf::Texture* texture);
+    const sf::Texture* getTexture() const;
+
+    void clear();
+    void reserve(std::size_t quads);
+
+    // adds textureRect scaled and rotated (in degrees) about origin, with origin placed at position
+    void add(sf::Vector2f position, float rotation, const sf::IntRect& textureRect, const sf::Color& color = sf::Color::White,
+             sf::Vector2f origin = sf::Vector2f(), sf::Vector2f scale = sf::Vector2f(1.f, 1.f));
+    // adds the sprite as it would be drawn with transform. Returns false when it uses another texture.
+    bool add(const sf::Sprite& sprite, const sf::Transform& transform = sf::Transform::Identity);
+    // adds quads already in the space the batch is drawn in, four vertices each
+    void add(const sf::Vertex* vertices, std::size_t count);
+
+    std::size_t getQuadCount() const;
+
+    // the quad of a sprite in its local space, in the same layout sf::Sprite uses
+    static void getQuad(const sf::Sprite& sprite, sf::Vertex* quad);
+
+private:
+    virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+    void addQuad(const sf::Transform& transform, const sf::IntRect& textureRect, const sf::Color& color);
+
+    const sf::Texture* mTexture;
+    std::vector<sf::Vertex> mVertices;
+};
\ No newline at end of file
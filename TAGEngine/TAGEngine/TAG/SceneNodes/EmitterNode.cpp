@@ -96,6 +96,12 @@ void EmitterNode::updateCurrent(sf::Time dt, CommandQueue& commands)
 	}
 }
 
+bool EmitterNode::getDrawBounds(const sf::Transform&, sf::FloatRect&) const
+{
+    // emitters draw nothing, so their empty bounds never stop a parent being culled
+    return true;
+}
+
 void EmitterNode::emitParticles(sf::Time dt)
 {
     mAccumulatedTime += dt;
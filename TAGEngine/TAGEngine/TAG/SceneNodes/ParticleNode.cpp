@@ -1,4 +1,5 @@
 #include "ParticleNode.hpp"
+#include "RenderQueue.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/Texture.hpp>
@@ -162,6 +163,17 @@ void ParticleNode::drawCurrent(sf::RenderTarget& target, sf::RenderStates states
 	target.draw(mVertexArray, states);
 }
 
+void ParticleNode::recordCurrent(RenderQueue& queue, sf::RenderStates states) const
+{
+    queue.addNode(*this, states);
+}
+
+bool ParticleNode::getDrawBounds(const sf::Transform&, sf::FloatRect&) const
+{
+    // particles are emitted in world space wherever their emitters are, so never cull them
+    return false;
+}
+
 void ParticleNode::computeVertices() const
 {
 	// Clear vertex array (keeps memory allocated)
@@ -65,6 +65,8 @@ public:
 private:
     virtual void updateCurrent(sf::Time dt, CommandQueue& commands);
 	virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
+    virtual void recordCurrent(RenderQueue& queue, sf::RenderStates states) const;
+    virtual bool getDrawBounds(const sf::Transform& transform, sf::FloatRect& bounds) const;
 	
 	// Recomputes the vertex array.
 	void computeVertices() const;
@@ -0,0 +1,271 @@
+#include "RenderQueue.hpp"
+#include "SceneNode.hpp"
+#include "SpriteBatch.hpp"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+    bool sameStates(const RenderQueue::Command& a, const RenderQueue::Command& b)
+    {
+        return a.texture == b.texture && a.shader == b.shader && a.blendMode == b.blendMode;
+    }
+    
+    // commands are drawn in this order, ties keep the order they were recorded in
+    bool drawnBefore(const RenderQueue::Command& a, const RenderQueue::Command& b)
+    {
+        if(a.layer != b.layer) return a.layer < b.layer;
+        if(a.segment != b.segment) return a.segment < b.segment;
+        if(a.textureId != b.textureId) return a.textureId < b.textureId;
+        return a.shaderId < b.shaderId;
+    }
+    
+    // a frame rarely uses more than a handful of textures, so a linear search will do
+    template <typename T>
+    sf::Uint32 findId(std::vector<const T*>& states, const T* state)
+    {
+        const auto i = std::find(states.begin(), states.end(), state);
+        if(i != states.end()) return static_cast<sf::Uint32>(i - states.begin());
+        
+        states.push_back(state);
+        return static_cast<sf::Uint32>(states.size() - 1u);
+    }
+}
+
+RenderQueue::RenderQueue()
+ : mLayer(0)
+ , mSegment(0u)
+ , mSorted(true)
+ , mDrawCalls(0u)
+ , mCullRect()
+ , mRecordedNodes(0u)
+ , mCulledNodes(0u)
+{}
+
+void RenderQueue::clear()
+{
+    mCommands.clear();
+    mVertices.clear();
+    mTextures.clear();
+    mShaders.clear();
+    mLayer = 0;
+    mSegment = 0u;
+    mSorted = true;
+    mRecordedNodes = 0u;
+    mCulledNodes = 0u;
+}
+
+void RenderQueue::setLayer(int layer)
+{
+    mLayer = layer;
+}
+
+int RenderQueue::getLayer() const
+{
+    return mLayer;
+}
+
+void RenderQueue::setCullRect(const sf::FloatRect& rect)
+{
+    mCullRect = rect;
+}
+
+const sf::FloatRect& RenderQueue::getCullRect() const
+{
+    return mCullRect;
+}
+
+bool RenderQueue::cull(bool bounded, const sf::FloatRect& bounds, sf::Uint32 nodes)
+{
+    const bool culling = mCullRect.width > 0.f && mCullRect.height > 0.f;
+    if(bounded && culling && !bounds.intersects(mCullRect))
+    {
+        mCulledNodes += nodes;
+        return true;
+    }
+    ++mRecordedNodes;
+    return false;
+}
+
+sf::Uint32 RenderQueue::getRecordedNodes() const
+{
+    return mRecordedNodes;
+}
+
+sf::Uint32 RenderQueue::getCulledNodes() const
+{
+    return mCulledNodes;
+}
+
+void RenderQueue::addQuad(const sf::Vertex* quad, const sf::RenderStates& states)
+{
+    const sf::Uint32 first = mVertices.size();
+    for(int i = 0; i < 4; ++i)
+    {
+        sf::Vertex vertex = quad[i];
+        vertex.position = states.transform.transformPoint(vertex.position);
+        mVertices.push_back(vertex);
+    }
+
+    Command command;
+    command.layer = mLayer;
+    command.segment = mSegment;
+    command.texture = states.texture;
+    command.shader = states.shader;
+    command.blendMode = states.blendMode;
+    command.firstVertex = first;
+    command.vertexCount = 4u;
+    command.node = nullptr;
+
+    // quads recorded one after another with the same states share a command,
+    // which leaves less to sort when most of a layer uses one texture
+    if(!mCommands.empty())
+    {
+        Command& last = mCommands.back();
+        if(!last.node && last.layer == command.layer && last.segment == command.segment
+            && sameStates(last, command) && last.firstVertex + last.vertexCount == first)
+        {
+            last.vertexCount += 4u;
+            return;
+        }
+    }
+    command.textureId = getTextureId(command.texture);
+    command.shaderId = getShaderId(command.shader);
+    mCommands.push_back(command);
+    mSorted = false;
+}
+
+void RenderQueue::addSprite(const sf::Sprite& sprite, sf::RenderStates states)
+{
+    if(!sprite.getTexture()) return;
+
+    states.transform *= sprite.getTransform();
+    states.texture = sprite.getTexture();
+
+    sf::Vertex quad[4];
+    SpriteBatch::getQuad(sprite, quad);
+    addQuad(quad, states);
+}
+
+void RenderQueue::addNode(const SceneNode& node, const sf::RenderStates& states)
+{
+    // the node gets a segment of its own, so quads recorded before or after it are never sorted past it
+    Command command;
+    command.layer = mLayer;
+    command.segment = ++mSegment;
+    ++mSegment;
+    command.texture = states.texture;
+    command.shader = states.shader;
+    command.textureId = getTextureId(states.texture);
+    command.shaderId = getShaderId(states.shader);
+    command.blendMode = states.blendMode;
+    command.transform = states.transform;
+    command.firstVertex = 0u;
+    command.vertexCount = 0u;
+    command.node = &node;
+
+    mCommands.push_back(command);
+    mSorted = false;
+}
+
+void RenderQueue::sort()
+{
+    if(mSorted) return;
+
+    std::stable_sort(mCommands.begin(), mCommands.end(), drawnBefore);
+    mSorted = true;
+    
+#ifdef TAG_CHECK_RENDER_QUEUE
+    checkOrder();
+#endif
+}
+
+const std::vector<RenderQueue::Command>& RenderQueue::getCommands() const
+{
+    return mCommands;
+}
+
+void RenderQueue::submit(sf::RenderTarget& target)
+{
+    sort();
+    mDrawCalls = 0u;
+    mBatch.clear();
+
+    sf::RenderStates batchStates;
+    const Command* batchCommand = nullptr;
+    for(const auto& command : mCommands)
+    {
+        if(batchCommand && (command.node || !sameStates(*batchCommand, command)))
+        {
+            flush(target, batchStates);
+            batchCommand = nullptr;
+        }
+
+        if(command.node)
+        {
+            sf::RenderStates states(command.blendMode, command.transform, command.texture, command.shader);
+            command.node->drawCurrent(target, states);
+            ++mDrawCalls;
+            continue;
+        }
+
+        if(!batchCommand)
+        {
+            batchCommand = &command;
+            batchStates = sf::RenderStates(command.blendMode, sf::Transform::Identity, command.texture, command.shader);
+        }
+        mBatch.add(&mVertices[command.firstVertex], command.vertexCount);
+    }
+    if(batchCommand) flush(target, batchStates);
+}
+
+sf::Uint32 RenderQueue::getDrawCalls() const
+{
+    return mDrawCalls;
+}
+
+void RenderQueue::flush(sf::RenderTarget& target, const sf::RenderStates& states)
+{
+    if(mBatch.getQuadCount() == 0u) return;
+
+    mBatch.setTexture(states.texture);
+    target.draw(mBatch, states);
+    mBatch.clear();
+    ++mDrawCalls;
+}
+
+sf::Uint32 RenderQueue::getTextureId(const sf::Texture* texture)
+{
+    return findId(mTextures, texture);
+}
+
+sf::Uint32 RenderQueue::getShaderId(const sf::Shader* shader)
+{
+    return findId(mShaders, shader);
+}
+
+void RenderQueue::checkOrder() const
+{
+    for(std::size_t i = 0u; i < mCommands.size(); ++i)
+    {
+        const Command& b = mCommands[i];
+        assert(b.textureId < mTextures.size() && mTextures[b.textureId] == b.texture);
+        assert(b.shaderId < mShaders.size() && mShaders[b.shaderId] == b.shader);
+        if(i == 0u) continue;
+        
+        const Command& a = mCommands[i - 1u];
+        assert(!drawnBefore(b, a));
+        
+        // nodes are never sorted past anything on their layer, and tied quads keep their recorded order
+        if(a.layer == b.layer)
+        {
+            assert(a.segment != b.segment || (!a.node && !b.node));
+            assert(drawnBefore(a, b) || a.firstVertex + a.vertexCount <= b.firstVertex);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+// Records the draws of a scene graph traversal rather than issuing them straight away, so they
+// can be sorted by layer and texture and submitted as a few batched vertex arrays instead of a
+// draw call (and texture bind) per node.
+
+#include "SpriteBatch.hpp"
+
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <vector>
+
+namespace sf
+{
+    class RenderTarget;
+    class Sprite;
+}
+
+class SceneNode;
+
+class RenderQueue final : private sf::NonCopyable
+{
+public:
+    struct Command
+    {
+        int layer;
+        // bumped after every node which can't be batched, so batches are never sorted past one
+        sf::Uint32 segment;
+        const sf::Texture* texture;
+        const sf::Shader* shader;
+        // textures and shaders numbered in the order they were first recorded since the last clear,
+        // so the sorted order doesn't depend on where they happen to be in memory
+        sf::Uint32 textureId;
+        sf::Uint32 shaderId;
+        sf::BlendMode blendMode;
+        // quads are transformed when recorded, so this is only used to draw nodes
+        sf::Transform transform;
+        sf::Uint32 firstVertex;
+        sf::Uint32 vertexCount;
+        // drawn with its drawCurrent when not null
+        const SceneNode* node;
+    };
+
+    RenderQueue();
+
+    void clear();
+
+    // layer commands are recorded on, lower layers are drawn first
+    void setLayer(int layer);
+    int getLayer() const;
+
+    // subtrees whose cached bounds (see SceneNode::updateBounds) lie outside rect are skipped.
+    // An empty rect records everything.
+    void setCullRect(const sf::FloatRect& rect);
+    const sf::FloatRect& getCullRect() const;
+    // counts a subtree of nodes as culled and returns true when its bounds are outside the cull
+    // rect, otherwise counts its root as recorded
+    bool cull(bool bounded, const sf::FloatRect& bounds, sf::Uint32 nodes);
+    // nodes recorded and culled since the last clear
+    sf::Uint32 getRecordedNodes() const;
+    sf::Uint32 getCulledNodes() const;
+
+    // records a textured quad of four vertices in local space
+    void addQuad(const sf::Vertex* quad, const sf::RenderStates& states);
+    void addSprite(const sf::Sprite& sprite, sf::RenderStates states);
+    // records a node to be drawn by its own drawCurrent, for anything which isn't made of quads
+    void addNode(const SceneNode& node, const sf::RenderStates& states);
+
+    // orders commands by layer then texture. Commands on the same layer with the same
+    // texture and shader keep the order they were recorded in. Define TAG_CHECK_RENDER_QUEUE
+    // in a debug build to assert the sorted order on every sort.
+    void sort();
+    const std::vector<Command>& getCommands() const;
+    // sorts the commands if needed then draws them, neighbouring quads with the same states
+    // are drawn together as one SpriteBatch
+    void submit(sf::RenderTarget& target);
+    // draw calls issued by the last submit
+    sf::Uint32 getDrawCalls() const;
+
+private:
+    void flush(sf::RenderTarget& target, const sf::RenderStates& states);
+    sf::Uint32 getTextureId(const sf::Texture* texture);
+    sf::Uint32 getShaderId(const sf::Shader* shader);
+    void checkOrder() const;
+
+    std::vector<Command> mCommands;
+    std::vector<sf::Vertex> mVertices;
+    SpriteBatch mBatch;
+    std::vector<const sf::Texture*> mTextures;
+    std::vector<const sf::Shader*> mShaders;
+    int mLayer;
+    sf::Uint32 mSegment;
+    bool mSorted;
+    sf::Uint32 mDrawCalls;
+    sf::FloatRect mCullRect;
+    sf::Uint32 mRecordedNodes;
+    sf::Uint32 mCulledNodes;
+};
\ No newline at end of file
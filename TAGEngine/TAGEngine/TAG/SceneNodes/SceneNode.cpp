@@ -1,5 +1,6 @@
 #include "SceneNode.hpp"
 #include "Command.hpp"
+#include "RenderQueue.hpp"
 #include "Utility.hpp"
 
 #include <SFML/Graphics/RectangleShape.hpp>
@@ -9,16 +10,45 @@
 #include <cassert>
 #include <iostream>
 
+namespace
+{
+    // rects with no area are treated as empty rather than as a point
+    void unite(sf::FloatRect& rect, const sf::FloatRect& other)
+    {
+        if(other.width <= 0.f || other.height <= 0.f) return;
+        if(rect.width <= 0.f || rect.height <= 0.f)
+        {
+            rect = other;
+            return;
+        }
+        
+        const float right = std::max(rect.left + rect.width, other.left + other.width);
+        const float bottom = std::max(rect.top + rect.height, other.top + other.height);
+        rect.left = std::min(rect.left, other.left);
+        rect.top = std::min(rect.top, other.top);
+        rect.width = right - rect.left;
+        rect.height = bottom - rect.top;
+    }
+}
+
 SceneNode::SceneNode(unsigned int category)
  : mChildren()
  , mParent(nullptr)
  , mDefaultCategory(category)
+ , mDrawLayer(-1)
+ , mSubtreeBounds()
+ , mBounded(false)
+ , mSubtreeSize(1u)
 {}
 
 void SceneNode::attachChild(Ptr child)
 {
     child->mParent = this;
 	mChildren.push_back(std::move(child));
+    
+    // cached bounds don't cover the new child until the next updateBounds
+    for(SceneNode* node = this; node; node = node->mParent)
+        node->mBounded = false;
 }
 
 SceneNode::Ptr SceneNode::detachChild(const SceneNode& node)
@@ -67,6 +97,61 @@ void SceneNode::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) c
     // Do nothing by default
 }
 
+void SceneNode::record(RenderQueue& queue, sf::RenderStates states) const
+{
+    if(queue.cull(mBounded, mSubtreeBounds, mSubtreeSize)) return;
+    
+    states.transform *= getTransform();
+
+    const int parentLayer = queue.getLayer();
+    if(mDrawLayer >= 0) queue.setLayer(mDrawLayer);
+
+    recordCurrent(queue, states);
+    for(const Ptr& child: mChildren)
+        child->record(queue, states);
+
+    queue.setLayer(parentLayer);
+}
+
+void SceneNode::recordCurrent(RenderQueue&, sf::RenderStates) const
+{
+    // Do nothing by default
+}
+
+void SceneNode::setDrawLayer(int layer)
+{
+    mDrawLayer = layer;
+}
+
+int SceneNode::getDrawLayer() const
+{
+    return mDrawLayer;
+}
+
+void SceneNode::updateBounds(sf::Transform parentTransform)
+{
+    parentTransform *= getTransform();
+    
+    mSubtreeBounds = sf::FloatRect();
+    mBounded = getDrawBounds(parentTransform, mSubtreeBounds);
+    mSubtreeSize = 1u;
+    
+    for(const Ptr& child: mChildren)
+    {
+        child->updateBounds(parentTransform);
+        unite(mSubtreeBounds, child->mSubtreeBounds);
+        mBounded = mBounded && child->mBounded;
+        mSubtreeSize += child->mSubtreeSize;
+    }
+}
+
+bool SceneNode::getDrawBounds(const sf::Transform&, sf::FloatRect& bounds) const
+{
+    // a node without a bounding rect may still draw something, so it's never culled
+    bounds = getBoundingRect();
+    return bounds.width > 0.f && bounds.height > 0.f;
+}
+
 void SceneNode::drawChildren(sf::RenderTarget& target, sf::RenderStates states) const
 {
     for(const Ptr& child: mChildren)
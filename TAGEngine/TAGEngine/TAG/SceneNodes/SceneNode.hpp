@@ -14,6 +14,7 @@
 
 struct Command;
 class CommandQueue;
+class RenderQueue;
 
 class SceneNode : public sf::Transformable, public sf::Drawable, private sf::NonCopyable
 {
@@ -42,19 +43,45 @@ public:
 	virtual bool isDestroyed() const;
     
     void debugAction(const std::string& text);
+    
+    // records the node and its children into queue, to be sorted and drawn in batches by RenderQueue::submit
+    void record(RenderQueue& queue, sf::RenderStates states) const;
+    // layer the node and its children are recorded on, -1 to use the layer of the parent
+    void setDrawLayer(int layer);
+    int getDrawLayer() const;
+    // caches the world bounds of every node and its subtree, which record uses to skip subtrees
+    // outside the cull rect of the queue. Call it after the scene has moved for the frame.
+    void updateBounds(sf::Transform parentTransform = sf::Transform::Identity);
 	
 private:
     virtual void updateCurrent(sf::Time dt, CommandQueue& commands);
 	void updateChildren(sf::Time dt, CommandQueue& commands);
 	
 	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+	// nodes which override drawCurrent must also override recordCurrent, otherwise they draw
+	// directly but vanish from scenes drawn through a RenderQueue
 	virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
 	void drawChildren(sf::RenderTarget& target, sf::RenderStates states) const;
 	void drawBoundingRect(sf::RenderTarget& target, sf::RenderStates states) const;
+    // records nothing by default, like drawCurrent, so nodes which only group or update their
+    // children add nothing to the queue. Nodes made of sprites override this to record quads which
+    // can be batched, any other node overriding drawCurrent records itself with RenderQueue::addNode.
+    virtual void recordCurrent(RenderQueue& queue, sf::RenderStates states) const;
+    // world bounds of everything drawCurrent draws, given the world transform of the node. Uses
+    // getBoundingRect by default, and returns false so the node is never culled when that has no
+    // area. Nodes which draw nothing return true with empty bounds so their parents can be culled.
+    virtual bool getDrawBounds(const sf::Transform& transform, sf::FloatRect& bounds) const;
+    
+    friend class RenderQueue;
 	
 	std::vector<Ptr> mChildren;
 	SceneNode* mParent;
 	unsigned int mDefaultCategory;
+    int mDrawLayer;
+    // cached by updateBounds. Unbounded subtrees are always recorded.
+    sf::FloatRect mSubtreeBounds;
+    bool mBounded;
+    sf::Uint32 mSubtreeSize;
 };
 
 bool collision(const SceneNode& lhs, const SceneNode& rhs);
@@ -15,3 +15,9 @@ unsigned int SoundNode::getCategory() const
 {
     return Category::SoundEffect;
 }
+
+bool SoundNode::getDrawBounds(const sf::Transform&, sf::FloatRect&) const
+{
+    // nothing is drawn, so the empty bounds never stop a parent being culled
+    return true;
+}
@@ -13,5 +13,7 @@ public:
 	virtual unsigned int getCategory() const;
 	
 private:
+    virtual bool getDrawBounds(const sf::Transform& transform, sf::FloatRect& bounds) const;
+    
     SoundPlayer& mSounds;
 };
\ No newline at end of file
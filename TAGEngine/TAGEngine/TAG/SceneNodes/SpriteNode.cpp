@@ -1,4 +1,5 @@
 #include "SpriteNode.hpp"
+#include "RenderQueue.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 
@@ -15,4 +16,15 @@ SpriteNode::SpriteNode(const sf::Texture& texture, const sf::IntRect& textureRec
 void SpriteNode::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
 {
     target.draw(mSprite, states);
+}
+
+void SpriteNode::recordCurrent(RenderQueue& queue, sf::RenderStates states) const
+{
+    queue.addSprite(mSprite, states);
+}
+
+bool SpriteNode::getDrawBounds(const sf::Transform& transform, sf::FloatRect& bounds) const
+{
+    bounds = transform.transformRect(mSprite.getGlobalBounds());
+    return true;
 }
\ No newline at end of file
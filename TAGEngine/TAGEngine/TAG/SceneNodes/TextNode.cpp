@@ -1,4 +1,5 @@
 #include "TextNode.hpp"
+#include "RenderQueue.hpp"
 #include "Utility.hpp"
 #include "Defaults.hpp"
 
@@ -16,6 +17,18 @@ void TextNode::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) co
     target.draw(mText, states);
 }
 
+void TextNode::recordCurrent(RenderQueue& queue, sf::RenderStates states) const
+{
+    // text has a glyph quad per character from the font's own texture, so it's drawn as it is
+    queue.addNode(*this, states);
+}
+
+bool TextNode::getDrawBounds(const sf::Transform& transform, sf::FloatRect& bounds) const
+{
+    bounds = transform.transformRect(mText.getGlobalBounds());
+    return true;
+}
+
 void TextNode::setString(const std::string& text)
 {
     mText.setString(text);
@@ -14,6 +14,8 @@ public:
 	
 private:
     virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
+    virtual void recordCurrent(RenderQueue& queue, sf::RenderStates states) const;
+    virtual bool getDrawBounds(const sf::Transform& transform, sf::FloatRect& bounds) const;
 	
 	sf::Text mText;
 };
\ No newline at end of file
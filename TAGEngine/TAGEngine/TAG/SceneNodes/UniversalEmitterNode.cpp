@@ -96,6 +96,12 @@ void UniversalEmitterNode::updateCurrent(sf::Time dt, CommandQueue& commands)
 	}
 }
 
+bool UniversalEmitterNode::getDrawBounds(const sf::Transform&, sf::FloatRect&) const
+{
+    // emitters draw nothing, so their empty bounds never stop a parent being culled
+    return true;
+}
+
 void UniversalEmitterNode::emitParticles(sf::Time dt)
 {	
 	mAccumulatedTime += dt;
@@ -77,6 +77,7 @@ public:
 	
 private:
     virtual void updateCurrent(sf::Time dt, CommandQueue& commands);
+    virtual bool getDrawBounds(const sf::Transform& transform, sf::FloatRect& bounds) const;
 	void emitParticles(sf::Time dt);
 	
 	float mEmissionRate;
@@ -0,0 +1,111 @@
+#include "ChunkStreamer.hpp"
+
+#include <SFML/System/Lock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <utility>
+
+ChunkStreamer::ChunkStreamer(BuildFunction build)
+ : mBuild(build)
+ , mThread(&ChunkStreamer::run, this)
+ , mRunning(false)
+ , mDiscardBuilding(false)
+ , mBuilding(-1)
+{}
+
+ChunkStreamer::~ChunkStreamer()
+{
+    stop();
+}
+
+void ChunkStreamer::start()
+{
+    {
+        sf::Lock lock(mMutex);
+        if(mRunning) return;
+        mRunning = true;
+    }
+    mThread.launch();
+}
+
+void ChunkStreamer::stop()
+{
+    {
+        sf::Lock lock(mMutex);
+        mRunning = false;
+        mRequests.clear();
+    }
+    mThread.wait();
+}
+
+void ChunkStreamer::setRequests(const std::vector<sf::Uint32>& chunks)
+{
+    sf::Lock lock(mMutex);
+    mRequests.clear();
+    for(const auto chunk : chunks)
+    {
+        if(chunk == mBuilding) continue;
+
+        auto finished = std::find_if(mFinished.begin(), mFinished.end(), [chunk](const MapChunk& c){ return c.index == chunk; });
+        if(finished == mFinished.end()) mRequests.push_back(chunk);
+    }
+}
+
+sf::Mutex& ChunkStreamer::getBuildMutex()
+{
+    return mBuildMutex;
+}
+
+void ChunkStreamer::invalidate(sf::Uint32 chunk)
+{
+    sf::Lock lock(mMutex);
+    mFinished.erase(std::remove_if(mFinished.begin(), mFinished.end(), [chunk](const MapChunk& c){ return c.index == chunk; }), mFinished.end());
+    if(chunk == mBuilding) mDiscardBuilding = true;
+}
+
+void ChunkStreamer::collect(std::vector<MapChunk>& dest)
+{
+    sf::Lock lock(mMutex);
+    for(auto& chunk : mFinished)
+        dest.push_back(std::move(chunk));
+    mFinished.clear();
+}
+
+void ChunkStreamer::run()
+{
+    while(true)
+    {
+        MapChunk chunk;
+        bool requested = false;
+        {
+            sf::Lock lock(mMutex);
+            if(!mRunning) return;
+
+            if(!mRequests.empty())
+            {
+                chunk.index = mRequests.front();
+                mRequests.pop_front();
+                mBuilding = chunk.index;
+                requested = true;
+            }
+        }
+
+        // sfml has no condition variable so poll for new requests while idle
+        if(!requested)
+        {
+            sf::sleep(sf::milliseconds(2));
+            continue;
+        }
+
+        {
+            sf::Lock buildLock(mBuildMutex);
+            mBuild(chunk);
+        }
+
+        sf::Lock lock(mMutex);
+        if(!mDiscardBuilding) mFinished.push_back(std::move(chunk));
+        mDiscardBuilding = false;
+        mBuilding = -1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+// Builds the vertices of tile map chunks on a background thread. A chunk is a square of
+// patchSize x patchSize tiles, matching the patches of each LayerSet, so a finished chunk
+// can be swapped straight into the layer sets of every tile layer it covers.
+
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Thread.hpp>
+#include <SFML/System/Mutex.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <vector>
+#include <deque>
+#include <functional>
+
+// the vertices of one chunk which are drawn by a single layer set
+struct ChunkPatch
+{
+    sf::Uint16 layer;
+    sf::Uint16 tileset;
+    std::vector<sf::Vertex> vertices;
+};
+
+struct MapChunk
+{
+    sf::Uint32 index;
+    std::vector<ChunkPatch> patches;
+};
+
+class ChunkStreamer final : private sf::NonCopyable
+{
+public:
+    // called on the loader thread to fill in the patches of a chunk
+    typedef std::function<void(MapChunk&)> BuildFunction;
+
+    explicit ChunkStreamer(BuildFunction build);
+    ~ChunkStreamer();
+
+    void start();
+    // waits for the chunk currently being built then stops the loader thread
+    void stop();
+
+    // replaces any chunks still waiting to be built with the given chunks, which are built in order.
+    // chunks already being built or waiting to be collected are skipped.
+    void setRequests(const std::vector<sf::Uint32>& chunks);
+    // held by the loader thread while building a chunk. Lock it to change the data chunks are
+    // built from, then invalidate the chunks affected before unlocking.
+    sf::Mutex& getBuildMutex();
+    // drops any finished or in progress build of chunk, so it is built again when next requested
+    void invalidate(sf::Uint32 chunk);
+    // moves any finished chunks onto the end of dest
+    void collect(std::vector<MapChunk>& dest);
+
+private:
+    void run();
+
+    BuildFunction mBuild;
+    sf::Thread mThread;
+    sf::Mutex mMutex;
+    sf::Mutex mBuildMutex;
+    bool mRunning;
+    bool mDiscardBuilding; // set when the chunk being built is invalidated
+
+    std::deque<sf::Uint32> mRequests;
+    std::vector<MapChunk> mFinished;
+    sf::Int64 mBuilding; // index of the chunk being built, -1 when idle
+};
\ No newline at end of file
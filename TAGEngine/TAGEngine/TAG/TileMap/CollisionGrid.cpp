@@ -0,0 +1,248 @@
+#include "CollisionGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+CollisionGrid::CollisionGrid()
+ : mCols(0u)
+ , mRows(0u)
+ , mTileSize(1.f, 1.f)
+{}
+
+void CollisionGrid::create(unsigned int cols, unsigned int rows, const sf::Vector2f& tileSize)
+{
+    mTiles.assign(cols * rows, 0u);
+    mCols = cols;
+    mRows = rows;
+    mTileSize = tileSize;
+}
+
+void CollisionGrid::clear()
+{
+    mTiles.clear();
+    mCols = mRows = 0u;
+}
+
+bool CollisionGrid::empty() const
+{
+    return mTiles.empty();
+}
+
+sf::Vector2u CollisionGrid::getSize() const
+{
+    return sf::Vector2u(mCols, mRows);
+}
+
+const sf::Vector2f& CollisionGrid::getTileSize() const
+{
+    return mTileSize;
+}
+
+void CollisionGrid::setSolid(unsigned int x, unsigned int y, bool solid)
+{
+    if(x < mCols && y < mRows)
+        mTiles[y * mCols + x] = solid ? 1u : 0u;
+}
+
+bool CollisionGrid::isSolid(int x, int y) const
+{
+    return x >= 0 && y >= 0 && static_cast<unsigned int>(x) < mCols && static_cast<unsigned int>(y) < mRows
+        && mTiles[y * mCols + x] != 0u;
+}
+
+bool CollisionGrid::isSolidAt(const sf::Vector2f& point) const
+{
+    return isSolid(static_cast<int>(std::floor(point.x / mTileSize.x)), static_cast<int>(std::floor(point.y / mTileSize.y)));
+}
+
+bool CollisionGrid::tileRange(float left, float top, float right, float bottom, sf::Vector2i& first, sf::Vector2i& last) const
+{
+    // right and bottom edges are exclusive, so areas only touching a tile don't include it
+    first.x = std::max(static_cast<int>(std::floor(left / mTileSize.x)), 0);
+    first.y = std::max(static_cast<int>(std::floor(top / mTileSize.y)), 0);
+    last.x = std::min(static_cast<int>(std::ceil(right / mTileSize.x)) - 1, static_cast<int>(mCols) - 1);
+    last.y = std::min(static_cast<int>(std::ceil(bottom / mTileSize.y)) - 1, static_cast<int>(mRows) - 1);
+    return first.x <= last.x && first.y <= last.y;
+}
+
+bool CollisionGrid::overlaps(const sf::FloatRect& area) const
+{
+    sf::Vector2i first, last;
+    if(!tileRange(area.left, area.top, area.left + area.width, area.top + area.height, first, last)) return false;
+    
+    for(int y = first.y; y <= last.y; ++y)
+    {
+        for(int x = first.x; x <= last.x; ++x)
+        {
+            if(mTiles[y * mCols + x]) return true;
+        }
+    }
+    return false;
+}
+
+bool CollisionGrid::raycast(const sf::Vector2f& start, const sf::Vector2f& end, RaycastHit& hit) const
+{
+    if(mTiles.empty()) return false;
+    
+    sf::Vector2i tile(static_cast<int>(std::floor(start.x / mTileSize.x)), static_cast<int>(std::floor(start.y / mTileSize.y)));
+    if(isSolid(tile.x, tile.y))
+    {
+        hit.tile = tile;
+        hit.point = start;
+        hit.normal = sf::Vector2f();
+        hit.distance = 0.f;
+        return true;
+    }
+    
+    const sf::Vector2f delta = end - start;
+    const float length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+    if(length == 0.f) return false;
+    const sf::Vector2f direction = delta / length;
+    
+    // distance along the ray to cross a whole tile on each axis, and to the next tile edge on each axis
+    const float infinity = std::numeric_limits<float>::infinity();
+    const sf::Vector2i step(direction.x > 0.f ? 1 : -1, direction.y > 0.f ? 1 : -1);
+    const sf::Vector2f crossing((direction.x != 0.f) ? std::abs(mTileSize.x / direction.x) : infinity,
+                                (direction.y != 0.f) ? std::abs(mTileSize.y / direction.y) : infinity);
+    sf::Vector2f next(infinity, infinity);
+    if(direction.x != 0.f) next.x = ((tile.x + (step.x > 0 ? 1 : 0)) * mTileSize.x - start.x) / direction.x;
+    if(direction.y != 0.f) next.y = ((tile.y + (step.y > 0 ? 1 : 0)) * mTileSize.y - start.y) / direction.y;
+    
+    // visit each tile the segment crosses, one tile edge at a time
+    const sf::Vector2i endTile(static_cast<int>(std::floor(end.x / mTileSize.x)), static_cast<int>(std::floor(end.y / mTileSize.y)));
+    int steps = std::abs(endTile.x - tile.x) + std::abs(endTile.y - tile.y);
+    while(steps-- > 0)
+    {
+        float distance = 0.f;
+        sf::Vector2f normal;
+        if(next.x < next.y)
+        {
+            tile.x += step.x;
+            distance = next.x;
+            next.x += crossing.x;
+            normal.x = static_cast<float>(-step.x);
+        }
+        else
+        {
+            tile.y += step.y;
+            distance = next.y;
+            next.y += crossing.y;
+            normal.y = static_cast<float>(-step.y);
+        }
+        if(distance > length) return false;
+        
+        if(isSolid(tile.x, tile.y))
+        {
+            hit.tile = tile;
+            hit.point = start + direction * distance;
+            hit.normal = normal;
+            hit.distance = distance;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CollisionGrid::sweep(const sf::FloatRect& box, const sf::Vector2f& displacement, SweepHit& hit) const
+{
+    // only tiles under the area the box passes through can be hit
+    const float right = box.left + box.width;
+    const float bottom = box.top + box.height;
+    sf::Vector2i first, last;
+    if(!tileRange(std::min(box.left, box.left + displacement.x), std::min(box.top, box.top + displacement.y),
+                  std::max(right, right + displacement.x), std::max(bottom, bottom + displacement.y), first, last))
+        return false;
+    
+    const float infinity = std::numeric_limits<float>::infinity();
+    bool found = false;
+    hit.time = 1.f;
+    for(int y = first.y; y <= last.y; ++y)
+    {
+        for(int x = first.x; x <= last.x; ++x)
+        {
+            if(!mTiles[y * mCols + x]) continue;
+            
+            const float tileLeft = x * mTileSize.x;
+            const float tileTop = y * mTileSize.y;
+            const float tileRight = tileLeft + mTileSize.x;
+            const float tileBottom = tileTop + mTileSize.y;
+            
+            // times at which the box starts and stops overlapping the tile on each axis. A box not
+            // moving on an axis overlaps for the whole move, or never if it's beside the tile.
+            float entryX = -infinity, exitX = infinity;
+            if(displacement.x > 0.f)
+            {
+                entryX = (tileLeft - right) / displacement.x;
+                exitX = (tileRight - box.left) / displacement.x;
+            }
+            else if(displacement.x < 0.f)
+            {
+                entryX = (tileRight - box.left) / displacement.x;
+                exitX = (tileLeft - right) / displacement.x;
+            }
+            else if(right <= tileLeft || box.left >= tileRight) continue;
+            
+            float entryY = -infinity, exitY = infinity;
+            if(displacement.y > 0.f)
+            {
+                entryY = (tileTop - bottom) / displacement.y;
+                exitY = (tileBottom - box.top) / displacement.y;
+            }
+            else if(displacement.y < 0.f)
+            {
+                entryY = (tileBottom - box.top) / displacement.y;
+                exitY = (tileTop - bottom) / displacement.y;
+            }
+            else if(bottom <= tileTop || box.top >= tileBottom) continue;
+            
+            const float entry = std::max(entryX, entryY);
+            const float exit = std::min(exitX, exitY);
+            if(entry < 0.f || entry > exit || entry > hit.time || (found && entry == hit.time)) continue;
+            
+            hit.tile = sf::Vector2i(x, y);
+            hit.time = entry;
+            hit.normal = (entryX > entryY) ? sf::Vector2f(displacement.x > 0.f ? -1.f : 1.f, 0.f)
+                                           : sf::Vector2f(0.f, displacement.y > 0.f ? -1.f : 1.f);
+            found = true;
+        }
+    }
+    return found;
+}
+
+void CollisionGrid::mergeSolidTiles(std::vector<sf::IntRect>& rectangles) const
+{
+    rectangles.clear();
+    std::vector<sf::Uint8> covered(mTiles.size(), 0u);
+    for(unsigned int y = 0u; y < mRows; ++y)
+    {
+        for(unsigned int x = 0u; x < mCols; ++x)
+        {
+            const unsigned int start = y * mCols + x;
+            if(!mTiles[start] || covered[start]) continue;
+            
+            // grow along the row while tiles are solid and uncovered
+            unsigned int width = 1u;
+            while(x + width < mCols && mTiles[start + width] && !covered[start + width])
+                ++width;
+            
+            // then down while every tile of the next row under the run is too
+            unsigned int height = 1u;
+            while(y + height < mRows)
+            {
+                const unsigned int row = start + height * mCols;
+                unsigned int i = 0u;
+                while(i < width && mTiles[row + i] && !covered[row + i])
+                    ++i;
+                if(i < width) break;
+                ++height;
+            }
+            
+            for(unsigned int j = 0u; j < height; ++j)
+                std::fill_n(covered.begin() + start + j * mCols, width, 1u);
+            
+            rectangles.push_back(sf::IntRect(x, y, width, height));
+            x += width - 1u;
+        }
+    }
+}
\ No newline at end of file
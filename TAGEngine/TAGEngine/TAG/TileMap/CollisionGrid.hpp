@@ -0,0 +1,67 @@
+#pragma once
+
+// A grid of solid and empty tiles, built by TileMap from a tile layer or a tile property, so
+// collision against walls made of tiles doesn't need a MapObject for every tile. Each tile is a
+// byte, so testing a tile is a single lookup, and queries only visit the tiles they pass over.
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <vector>
+
+class CollisionGrid final
+{
+public:
+    struct RaycastHit
+    {
+        sf::Vector2i tile; // grid position of the solid tile hit
+        sf::Vector2f point; // where the ray entered the tile
+        sf::Vector2f normal; // of the tile edge hit, zero when the ray starts inside a solid tile
+        float distance; // from the start of the ray to point
+    };
+    
+    struct SweepHit
+    {
+        sf::Vector2i tile;
+        sf::Vector2f normal;
+        float time; // fraction of the displacement moved before touching the tile, from 0 to 1
+    };
+    
+    CollisionGrid();
+    
+    // resizes the grid to cols x rows tiles, all of them empty
+    void create(unsigned int cols, unsigned int rows, const sf::Vector2f& tileSize);
+    void clear();
+    bool empty() const;
+    
+    sf::Vector2u getSize() const;
+    const sf::Vector2f& getTileSize() const;
+    
+    void setSolid(unsigned int x, unsigned int y, bool solid);
+    // tiles outside the grid are never solid
+    bool isSolid(int x, int y) const;
+    // tests the tile under a point in world coordinates
+    bool isSolidAt(const sf::Vector2f& point) const;
+    // true if any solid tile overlaps the area
+    bool overlaps(const sf::FloatRect& area) const;
+    
+    // steps through the tiles under the segment from start to end in order, and fills hit with the
+    // first solid tile found. Returns false if the segment only crosses empty tiles.
+    bool raycast(const sf::Vector2f& start, const sf::Vector2f& end, RaycastHit& hit) const;
+    // moves box by displacement and fills hit with the first solid tile it would touch. Tiles the box
+    // already overlaps are ignored so a box can always move out of a wall. Returns false if nothing is hit.
+    bool sweep(const sf::FloatRect& box, const sf::Vector2f& displacement, SweepHit& hit) const;
+    
+    // covers the solid tiles with rectangles, in tiles, by greedily growing each rectangle as wide
+    // then as tall as it can from the first uncovered solid tile in row order. Rectangles don't overlap.
+    void mergeSolidTiles(std::vector<sf::IntRect>& rectangles) const;
+    
+private:
+    std::vector<sf::Uint8> mTiles;
+    unsigned int mCols;
+    unsigned int mRows;
+    sf::Vector2f mTileSize;
+    
+    // the range of tiles covering an area, clamped to the grid. Returns false if it's outside the grid.
+    bool tileRange(float left, float top, float right, float bottom, sf::Vector2i& first, sf::Vector2i& last) const;
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "DebugDraw.hpp"
+#include "MapObject.hpp"
+
+namespace tmx
+{
+    void DebugDraw::clear()
+    {
+        mShapes.clear();
+        mGrid.clear();
+    }
+    
+    void DebugDraw::drawObject(sf::RenderTarget& rt, const MapObject& object)
+    {
+        const sf::Uint32 id = object.getId();
+        if(id >= mShapes.size()) mShapes.resize(id + 1u);
+        
+        std::unique_ptr<DebugShape>& shape = mShapes[id];
+        if(!shape)
+        {
+            shape = std::unique_ptr<DebugShape>(new DebugShape());
+            object.buildDebugShape(*shape);
+        }
+        
+        shape->setPosition(object.getPosition());
+        rt.draw(*shape);
+    }
+    
+    void DebugDraw::drawGrid(sf::RenderTarget& rt, const TileLayout& layout)
+    {
+        if(mGrid.getVertexCount() == 0u) buildGrid(layout);
+        rt.draw(mGrid);
+    }
+    
+    void DebugDraw::buildGrid(const TileLayout& layout)
+    {
+        const sf::Vector2u& tileCount = layout.getMapSize();
+        const sf::Vector2u& tileSize = layout.getTileSize();
+        sf::Color debugColour(0u, 0u, 0u, 120u);
+        
+        if(layout.getOrientation() == Isometric)
+        {
+            // lines along both axes of the grid, placed the way objects are
+            const float height = static_cast<float>(tileSize.y);
+            for(unsigned int x = 0u; x <= tileCount.x; ++x)
+            {
+                mGrid.append(sf::Vertex(layout.objectPosition(sf::Vector2f(x * height, 0.f)), debugColour));
+                mGrid.append(sf::Vertex(layout.objectPosition(sf::Vector2f(x * height, tileCount.y * height)), debugColour));
+            }
+            for(unsigned int y = 0u; y <= tileCount.y; ++y)
+            {
+                mGrid.append(sf::Vertex(layout.objectPosition(sf::Vector2f(0.f, y * height)), debugColour));
+                mGrid.append(sf::Vertex(layout.objectPosition(sf::Vector2f(tileCount.x * height, y * height)), debugColour));
+            }
+            mGrid.setPrimitiveType(sf::Lines);
+        }
+        else if(layout.getOrientation() == SteppedIsometric)
+        {
+            // stepped rows don't line up, so each tile's diamond is outlined
+            const sf::Vector2f half(tileSize.x / 2.f, tileSize.y / 2.f);
+            for(unsigned int y = 0u; y < tileCount.y; ++y)
+            {
+                for(unsigned int x = 0u; x < tileCount.x; ++x)
+                {
+                    const sf::Vector2f position = layout.tilePosition(x, y);
+                    const sf::Vector2f corners[] =
+                    {
+                        position + sf::Vector2f(half.x, 0.f),
+                        position + sf::Vector2f(half.x * 2.f, half.y),
+                        position + sf::Vector2f(half.x, half.y * 2.f),
+                        position + sf::Vector2f(0.f, half.y)
+                    };
+                    for(int i = 0; i < 4; ++i)
+                    {
+                        mGrid.append(sf::Vertex(corners[i], debugColour));
+                        mGrid.append(sf::Vertex(corners[(i + 1) % 4], debugColour));
+                    }
+                }
+            }
+            mGrid.setPrimitiveType(sf::Lines);
+        }
+        else
+        {
+            float mapHeight = static_cast<float>(tileSize.y * tileCount.y);
+            for(unsigned int x = 0u; x <= tileCount.x; x += 2u)
+            {
+                float posX = static_cast<float>(x * tileSize.x);
+                mGrid.append(sf::Vertex(sf::Vector2f(posX, 0.f), debugColour));
+                mGrid.append(sf::Vertex(sf::Vector2f(posX, mapHeight), debugColour));
+                posX += static_cast<float>(tileSize.x);
+                mGrid.append(sf::Vertex(sf::Vector2f(posX, mapHeight), debugColour));
+                mGrid.append(sf::Vertex(sf::Vector2f(posX, 0.f), debugColour));
+                posX += static_cast<float>(tileSize.x);
+                mGrid.append(sf::Vertex(sf::Vector2f(posX, 0.f), debugColour));
+            }
+            float mapWidth = static_cast<float>(tileSize.x * tileCount.x);
+            for(unsigned int y = 0u; y <= tileCount.y; y += 2u)
+            {
+                float posY = static_cast<float>(y * tileSize.y);
+                mGrid.append(sf::Vertex(sf::Vector2f(0.f, posY), debugColour));
+                posY += static_cast<float>(tileSize.y);
+                mGrid.append(sf::Vertex(sf::Vector2f(0.f, posY), debugColour));
+                mGrid.append(sf::Vertex(sf::Vector2f(mapWidth, posY), debugColour));
+                posY += static_cast<float>(tileSize.y);
+                mGrid.append(sf::Vertex(sf::Vector2f(mapWidth, posY), debugColour));
+            }
+            mGrid.setPrimitiveType(sf::LinesStrip);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+// Debug drawing for TileMap. Nothing here is built when a map is loaded: the map creates the
+// module the first time it's asked to debug draw, and each object outline and the tile grid are
+// built the first time they're drawn, so maps which are never debug drawn pay nothing for it.
+
+#include "DebugShape.hpp"
+#include "TileLayout.hpp"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+
+#include <memory>
+#include <vector>
+
+class MapObject;
+
+namespace tmx
+{
+    class DebugDraw final
+    {
+    public:
+        // drops every shape built so far, for example when the map is unloaded
+        void clear();
+        
+        // draws the outline of an object from the map's object store. Outlines are built in local
+        // space and cached by object id, so objects can move without rebuilding them.
+        void drawObject(sf::RenderTarget& rt, const MapObject& object);
+        
+        // draws lines between every other row and column of tiles, or the outlines of the
+        // tiles of isometric and stepped maps
+        void drawGrid(sf::RenderTarget& rt, const TileLayout& layout);
+        
+    private:
+        std::vector<std::unique_ptr<DebugShape>> mShapes; // by object id, null until first drawn
+        sf::VertexArray mGrid;
+        
+        void buildGrid(const TileLayout& layout);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "MapCache.hpp"
+#include "MappedFile.hpp"
+
+#include <fstream>
+
+sf::Uint64 tmx::hash(const char* data, std::size_t size, sf::Uint64 seed)
+{
+    const sf::Uint64 prime = 1099511628211ull;
+    sf::Uint64 result = seed;
+    for(std::size_t i = 0u; i < size; ++i)
+    {
+        result ^= static_cast<unsigned char>(data[i]);
+        result *= prime;
+    }
+    return result;
+}
+
+bool tmx::hashFile(const std::string& path, sf::Uint64& result)
+{
+    MappedFile file;
+    if(!file.open(path)) return false;
+    
+    result = hash(file.data(), file.size());
+    return true;
+}
+
+void CacheWriter::write(const std::string& str)
+{
+    write(static_cast<sf::Uint32>(str.size()));
+    mBuffer.insert(mBuffer.end(), str.begin(), str.end());
+}
+
+void CacheWriter::write(const std::map<std::string, std::string>& properties)
+{
+    write(static_cast<sf::Uint32>(properties.size()));
+    for(const auto& p : properties)
+    {
+        write(p.first);
+        write(p.second);
+    }
+}
+
+bool CacheWriter::save(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file.good()) return false;
+    
+    file.write(mBuffer.data(), mBuffer.size());
+    return file.good();
+}
+
+CacheReader::CacheReader(const char* data, std::size_t size)
+ : mData(data)
+ , mSize(size)
+ , mPosition(0u)
+ , mGood(data != nullptr)
+{}
+
+bool CacheReader::read(std::string& str)
+{
+    sf::Uint32 size = 0u;
+    if(!read(size)) return false;
+    
+    if(size > mSize - mPosition)
+    {
+        mGood = false;
+        return false;
+    }
+    
+    str.assign(mData + mPosition, size);
+    mPosition += size;
+    return true;
+}
+
+bool CacheReader::read(std::map<std::string, std::string>& properties)
+{
+    sf::Uint32 count = 0u;
+    if(!read(count)) return false;
+    
+    properties.clear();
+    std::string name, value;
+    for(sf::Uint32 i = 0u; i < count; ++i)
+    {
+        if(!read(name) || !read(value)) return false;
+        properties[name] = value;
+    }
+    return true;
+}
+
+bool CacheReader::readBytes(void* dest, std::size_t size)
+{
+    if(!mGood || size > mSize - mPosition)
+    {
+        mGood = false;
+        return false;
+    }
+    
+    std::memcpy(dest, mData + mPosition, size);
+    mPosition += size;
+    return true;
+}
\ No newline at end of file
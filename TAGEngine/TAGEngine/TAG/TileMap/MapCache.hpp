@@ -0,0 +1,76 @@
+#pragma once
+
+// Helpers for reading and writing the binary map cache created by TileMap after
+// a map has been parsed from xml. Values are stored in host byte order with no
+// padding, so a cache is only valid on the machine which wrote it - the header
+// records enough information to reject a cache written elsewhere.
+
+#include <SFML/Config.hpp>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+namespace tmx
+{
+    // bump whenever the layout of any cached data changes
+    const sf::Uint32 CacheVersion = 8u;
+    
+    // 64 bit FNV-1a hash of a block of memory
+    sf::Uint64 hash(const char* data, std::size_t size, sf::Uint64 seed = 14695981039346656037ull);
+    
+    // hashes the contents of a file, returns false if the file could not be read
+    bool hashFile(const std::string& path, sf::Uint64& result);
+}
+
+// Appends trivially copyable values to a memory buffer which can then be written to disk.
+class CacheWriter final
+{
+public:
+    template <typename T>
+    void write(const T& value);
+    void write(const std::string& str);
+    
+    // writes the number of elements followed by the raw element data
+    template <typename T>
+    void writeArray(const std::vector<T>& values);
+    
+    // writes a map of name/value properties
+    void write(const std::map<std::string, std::string>& properties);
+    
+    // writes the buffer to file, returns false on failure
+    bool save(const std::string& path) const;
+    
+private:
+    std::vector<char> mBuffer;
+};
+
+// Reads values written by CacheWriter from a block of memory, usually a mapped file.
+// Once any read runs past the end of the data the reader fails and all further reads return false.
+class CacheReader final
+{
+public:
+    CacheReader(const char* data, std::size_t size);
+    
+    template <typename T>
+    bool read(T& value);
+    bool read(std::string& str);
+    
+    template <typename T>
+    bool readArray(std::vector<T>& values);
+    
+    bool read(std::map<std::string, std::string>& properties);
+    
+    bool good() const { return mGood; }
+    
+private:
+    const char* mData;
+    std::size_t mSize;
+    std::size_t mPosition;
+    bool mGood;
+    
+    bool readBytes(void* dest, std::size_t size);
+};
+
+#include "MapCache.inl"
\ No newline at end of file
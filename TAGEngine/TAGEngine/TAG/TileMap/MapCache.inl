@@ -0,0 +1,41 @@
+#include <cstring>
+
+template <typename T>
+void CacheWriter::write(const T& value)
+{
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    mBuffer.insert(mBuffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+void CacheWriter::writeArray(const std::vector<T>& values)
+{
+    write(static_cast<sf::Uint32>(values.size()));
+    if(values.empty()) return;
+    
+    const char* bytes = reinterpret_cast<const char*>(values.data());
+    mBuffer.insert(mBuffer.end(), bytes, bytes + values.size() * sizeof(T));
+}
+
+template <typename T>
+bool CacheReader::read(T& value)
+{
+    return readBytes(&value, sizeof(T));
+}
+
+template <typename T>
+bool CacheReader::readArray(std::vector<T>& values)
+{
+    sf::Uint32 count = 0u;
+    if(!read(count)) return false;
+    
+    // reject counts which can't possibly fit in the remaining data before allocating
+    if(count > (mSize - mPosition) / sizeof(T))
+    {
+        mGood = false;
+        return false;
+    }
+    
+    values.resize(count);
+    return count == 0u || readBytes(values.data(), count * sizeof(T));
+}
\ No newline at end of file
@@ -1,14 +1,20 @@
 #include "MapLayer.hpp"
+#include "MapCache.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
 
 #include <cmath>
+#include <cassert>
+#include <algorithm>
 #include <iostream>
 
 TileQuad::TileQuad(sf::Uint16 i0, sf::Uint16 i1, sf::Uint16 i2, sf::Uint16 i3)
- : mParentSet(nullptr)
+ : mTexCoordsChanged(false)
+ , mParentSet(nullptr)
  , mPatchIndex(-1)
+ , mQuadIndex(0u)
+ , mGridIndex(0u)
  , mDirty(false)
 {
     mIndices[0] = i0;
@@ -19,7 +25,20 @@ TileQuad::TileQuad(sf::Uint16 i0, sf::Uint16 i1, sf::Uint16 i2, sf::Uint16 i3)
 
 void TileQuad::move(const sf::Vector2f& distance)
 {
-    mMovement = distance;
+    mMovement += distance;
+    setDirty();
+}
+
+void TileQuad::setTextureCoords(const std::array<sf::Vector2f, 4u>& coords)
+{
+    mTexCoords = coords;
+    mTexCoordsChanged = true;
+    setDirty();
+}
+
+void TileQuad::setDirty()
+{
+    // each quad is only queued once however many times it changes between updates
     if(!mDirty && mParentSet)
     {
         mDirty = true;
@@ -27,110 +46,489 @@ void TileQuad::move(const sf::Vector2f& distance)
     }
 }
 
-LayerSet::LayerSet(const sf::Texture& texture, sf::Uint8 patchSize, const sf::Vector2u& mapSize, const sf::Vector2u tileSize)
+DrawStats::DrawStats()
+ : drawCalls(0u)
+ , patches(0u)
+ , vertices(0u)
+{}
+
+LayerSet::LayerSet(const sf::Texture& texture, sf::Uint8 patchSize, const tmx::TileLayout& layout)
  : mTexture(texture)
  , mPatchSize(patchSize)
- , mMapSize(mapSize)
- , mTileSize(tileSize)
- , mPatchCount(std::ceil(static_cast<float>(mapSize.x) / patchSize)+1, std::ceil(static_cast<float>(mapSize.y) / patchSize)+1)
+ , mLayout(layout)
+ , mPatchCount(std::ceil(static_cast<float>(layout.getGridSize().x) / patchSize)+1, std::ceil(static_cast<float>(layout.getGridSize().y) / patchSize)+1)
+ , mSorted(layout.getOrientation() != tmx::Orthogonal)
+ , mVisibleRows(0, -1)
+ , mMergePatches(false)
+ , mMergeDirty(true)
  , mVisible(true)
+ , mBoundsGrown(false)
 {
     mPatches.resize(mPatchCount.x * mPatchCount.y);
+    mPatchQuads.resize(mPatches.size());
+    mPatchBounds.resize(mPatches.size());
+}
+
+void LayerSet::update()
+{
+    for(const auto& q : mDirtyQuads)
+    {
+        // the tile may have been removed since the quad was changed
+        if(q->mPatchIndex < 0)
+        {
+            q->mDirty = false;
+            continue;
+        }
+        
+        auto& patch = mPatches[q->mPatchIndex];
+        const sf::Int32 mergedOffset = getMergedOffset(q->mPatchIndex);
+        for(std::size_t i = 0u; i < q->mIndices.size(); ++i)
+        {
+            sf::Vertex& vertex = patch[q->mIndices[i]];
+            vertex.position += q->mMovement;
+            if(q->mTexCoordsChanged) vertex.texCoords = q->mTexCoords[i];
+            updateAABB(q->mPatchIndex, &vertex, 1u);
+            
+            // patches already merged are patched in place rather than merged again
+            if(mergedOffset >= 0) mMergedVertices[mergedOffset + q->mIndices[i]] = vertex;
+        }
+        
+        q->mMovement = sf::Vector2f();
+        q->mTexCoordsChanged = false;
+        q->mDirty = false;
+    }
+    mDirtyQuads.clear();
+    
+    // quads moved outside the set's bounds may now be in view
+    if(mBoundsGrown) cull(mCullBounds);
+    if(mMergePatches && mMergeDirty) mergePatches();
 }
 
 TileQuad* LayerSet::addTile(sf::Vertex vt0, sf::Vertex vt1, sf::Vertex vt2, sf::Vertex vt3, sf::Uint16 x, sf::Uint16 y)
 {
-    sf::Int32 patchX = static_cast<sf::Int32>(std::ceil(x / mPatchSize));
-    sf::Int32 patchY = static_cast<sf::Int32>(std::ceil(y / mPatchSize));
-    sf::Int32 patchIndex = mPatchCount.x * patchY + patchX;
+    const sf::Vector2i grid = mLayout.toGrid(x, y);
+    const sf::Int32 patchIndex = mPatchCount.x * (grid.y / mPatchSize) + (grid.x / mPatchSize);
+    const sf::Uint32 gridIndex = grid.y * mLayout.getGridSize().x + grid.x;
+    
+    // sorted patches insert the tile after any tiles before it. Tiles are loaded in row order
+    // so this is nearly always the end of the patch anyway.
+    auto& patch = mPatches[patchIndex];
+    auto& quads = mPatchQuads[patchIndex];
+    std::size_t slot = quads.size();
+    if(mSorted)
+    {
+        slot = std::upper_bound(quads.begin(), quads.end(), gridIndex,
+            [](sf::Uint32 index, const TileQuad* q){ return index < q->mGridIndex; }) - quads.begin();
+    }
+    const sf::Vertex vertices[] = { vt0, vt1, vt2, vt3 };
+    patch.insert(patch.begin() + slot * 4u, vertices, vertices + 4);
+    for(std::size_t j = slot; j < quads.size(); ++j)
+    {
+        for(auto& index : quads[j]->mIndices)
+            index += 4u;
+    }
     
-    mPatches[patchIndex].push_back(vt0);
-    mPatches[patchIndex].push_back(vt1);
-    mPatches[patchIndex].push_back(vt2);
-    mPatches[patchIndex].push_back(vt3);
+    sf::Uint16 i = static_cast<sf::Uint16>(slot * 4u);
+    
+    // reuse the quad of a removed tile if there is one
+    TileQuad* quad = nullptr;
+    if(!mFreeQuads.empty())
+    {
+        quad = mFreeQuads.back();
+        mFreeQuads.pop_back();
+        quad->mIndices = {{ i, static_cast<sf::Uint16>(i + 1), static_cast<sf::Uint16>(i + 2), static_cast<sf::Uint16>(i + 3) }};
+    }
+    else
+    {
+        mQuads.emplace_back(TileQuad::Ptr(new TileQuad(i, i + 1, i + 2, i + 3)));
+        quad = mQuads.back().get();
+        quad->mParentSet = this;
+        quad->mQuadIndex = mQuads.size() - 1u;
+    }
+    quad->mPatchIndex = patchIndex;
+    quad->mGridIndex = gridIndex;
+    quads.insert(quads.begin() + slot, quad);
     
-    sf::Uint16 i = mPatches[patchIndex].size() - 4u;
-    mQuads.emplace_back(TileQuad::Ptr(new TileQuad(i, i + 1, i + 2, i + 3)));
-    mQuads.back()->mParentSet = this;
-    mQuads.back()->mPatchIndex = patchIndex;
+    updateAABB(patchIndex, &patch[i], 4u);
+    mMergeDirty = true;
     
-    updateAABB(vt0.position, vt2.position);
+    // the first tile of a set culled while empty, or a tile outside its bounds, would otherwise
+    // stay hidden until the view next moves
+    if(mBoundsGrown) cull(mCullBounds);
     
-    return mQuads.back().get();
+    return quad;
 }
 
 void LayerSet::cull(const sf::FloatRect& bounds)
 {
+    mCullBounds = bounds;
+    mBoundsGrown = false;
     mVisible = mBoundingBox.intersects(bounds);
+    mVisibleRows = sf::Vector2i(0, -1);
+    mVisibleColumns.clear();
+    if(!mVisible) return;
     
-    // update visible patch indices
-    mVisiblePatchStart.x = static_cast<int>(std::floor((bounds.left / mTileSize.x) / mPatchSize));
-    mVisiblePatchStart.y = static_cast<int>(std::floor((bounds.top / mTileSize.y) / mPatchSize));
-    if(mVisiblePatchStart.x < 0) mVisiblePatchStart.x = 0;
-    if(mVisiblePatchStart.y < 0) mVisiblePatchStart.y = 0;
+    // the patches with grid cells overlapped by the bounds, widened by the furthest any patch spills outside its cells
+    const sf::FloatRect area(bounds.left - mPatchSpill.x, bounds.top - mPatchSpill.y,
+                             bounds.width + mPatchSpill.x * 2.f, bounds.height + mPatchSpill.y * 2.f);
+    const int patchSize = mPatchSize;
+    auto toPatch = [patchSize](int cell){ return (cell < 0) ? -1 : cell / patchSize; };
     
-    mVisiblePatchEnd.x = static_cast<int>(std::ceil((bounds.width / mTileSize.x) / mPatchSize));
-    mVisiblePatchEnd.y = static_cast<int>(std::ceil((bounds.height / mTileSize.y) / mPatchSize));
-    if(mVisiblePatchEnd.x > mPatchCount.x) mVisiblePatchEnd.x = mPatchCount.x;
-    if(mVisiblePatchEnd.y > mPatchCount.y) mVisiblePatchEnd.y = mPatchCount.y;
+    int first = 0, last = 0;
+    mLayout.gridRows(area, first, last);
+    mVisibleRows.x = std::max(toPatch(first), 0);
+    mVisibleRows.y = std::min(toPatch(last), static_cast<int>(mPatchCount.y) - 1);
+    for(int y = mVisibleRows.x; y <= mVisibleRows.y; ++y)
+    {
+        // isometric bounds cover a diamond of the grid, so each row of patches has its own columns
+        mLayout.gridColumns(area, y * patchSize, (y + 1) * patchSize - 1, first, last);
+        mVisibleColumns.push_back(sf::Vector2i(std::max(toPatch(first), 0), std::min(toPatch(last), static_cast<int>(mPatchCount.x) - 1)));
+    }
     
-    mVisiblePatchEnd += mVisiblePatchStart;
+    // the merged vertices only need rebuilding if a different set of patches is now visible
+    if(mMergePatches)
+    {
+        collectVisiblePatches(mVisiblePatches);
+        if(mMergeDirty || mVisiblePatches != mMergedPatches) mergePatches();
+    }
 }
 
-void LayerSet::draw(sf::RenderTarget& rt, sf::RenderStates states) const
+void LayerSet::setMergePatches(bool merge)
 {
-    for(const auto& q : mDirtyQuads)
+    mMergePatches = merge;
+    mMergeDirty = true;
+    if(merge)
     {
-        q->mDirty = false;
-        for(const auto& p : q->mIndices)
+        mMergedOffsets.assign(mPatches.size(), -1);
+    }
+    else
+    {
+        std::vector<sf::Uint32>().swap(mMergedPatches);
+        std::vector<sf::Int32>().swap(mMergedOffsets);
+        std::vector<sf::Vertex>().swap(mMergedVertices);
+    }
+}
+
+void LayerSet::collectVisiblePatches(std::vector<sf::Uint32>& dest) const
+{
+    dest.clear();
+    if(!mVisible) return;
+    
+    for(auto y = mVisibleRows.x; y <= mVisibleRows.y; ++y)
+    {
+        const sf::Vector2i& columns = mVisibleColumns[y - mVisibleRows.x];
+        for(auto x = columns.x; x <= columns.y; ++x)
         {
-            mPatches[q->mPatchIndex][p].position += q->mMovement;
+            const sf::Uint32 index = y * mPatchCount.x + x;
+            if(!mPatches[index].empty() && mPatchBounds[index].intersects(mCullBounds))
+                dest.push_back(index);
         }
     }
-    mDirtyQuads.clear();
+}
+
+sf::Int32 LayerSet::getMergedOffset(sf::Uint32 patchIndex) const
+{
+    // once tiles have been added or removed the offsets are stale until the next merge,
+    // which copies every visible patch again anyway
+    if(!mMergePatches || mMergeDirty) return -1;
+    return mMergedOffsets[patchIndex];
+}
+
+void LayerSet::mergePatches()
+{
+    if(mMergedOffsets.size() != mPatches.size())
+        mMergedOffsets.assign(mPatches.size(), -1);
+    for(const auto index : mMergedPatches)
+        mMergedOffsets[index] = -1;
     
-    if(!mVisible) return;
+    collectVisiblePatches(mMergedPatches);
+    
+    // clear keeps the capacity so scrolling around doesn't keep reallocating
+    mMergedVertices.clear();
+    for(const auto index : mMergedPatches)
+    {
+        mMergedOffsets[index] = static_cast<sf::Int32>(mMergedVertices.size());
+        mMergedVertices.insert(mMergedVertices.end(), mPatches[index].begin(), mPatches[index].end());
+    }
+    
+    mMergeDirty = false;
+}
+
+TileQuad* LayerSet::getQuad(sf::Uint32 index)
+{
+    return (index < mQuads.size()) ? mQuads[index].get() : nullptr;
+}
+
+sf::Uint32 LayerSet::getQuadIndex(const TileQuad* quad) const
+{
+    return quad->mQuadIndex;
+}
+
+void LayerSet::setTileVertices(TileQuad* quad, const std::array<sf::Vertex, 4u>& vertices)
+{
+    assert(quad->mParentSet == this && quad->mPatchIndex >= 0);
+    
+    auto& patch = mPatches[quad->mPatchIndex];
+    const sf::Int32 mergedOffset = getMergedOffset(quad->mPatchIndex);
+    for(std::size_t i = 0u; i < vertices.size(); ++i)
+    {
+        patch[quad->mIndices[i]] = vertices[i];
+        if(mergedOffset >= 0) mMergedVertices[mergedOffset + quad->mIndices[i]] = vertices[i];
+    }
+    updateAABB(quad->mPatchIndex, vertices.data(), vertices.size());
+    if(mBoundsGrown) cull(mCullBounds);
+}
+
+void LayerSet::removeTile(TileQuad* quad)
+{
+    assert(quad->mParentSet == this && quad->mPatchIndex >= 0);
+    
+    auto& patch = mPatches[quad->mPatchIndex];
+    auto& quads = mPatchQuads[quad->mPatchIndex];
+    const std::size_t slot = quad->mIndices[0] / 4u;
+    const std::size_t last = quads.size() - 1u;
     
-    for(auto x = mVisiblePatchStart.x; x <= mVisiblePatchEnd.x; ++x)
+    if(mSorted)
     {
-        for(auto y = mVisiblePatchStart.y; y <= mVisiblePatchEnd.y; ++y)
+        // keep the patch in draw order by closing the gap
+        patch.erase(patch.begin() + slot * 4u, patch.begin() + slot * 4u + 4u);
+        quads.erase(quads.begin() + slot);
+        for(std::size_t j = slot; j < quads.size(); ++j)
         {
-            auto index = y * mPatchCount.x + x;
-            if(index < mPatches.size() && !mPatches[index].empty())
-            {
-                states.texture = &mTexture;
-                rt.draw(mPatches[index].data(), static_cast<unsigned>(mPatches[index].size()), sf::Quads, states);
-            }
+            for(auto& index : quads[j]->mIndices)
+                index -= 4u;
         }
     }
+    else
+    {
+        // move the last quad of the patch into the removed quad's place so the patch stays packed
+        if(slot != last)
+        {
+            TileQuad* moved = quads[last];
+            for(std::size_t i = 0u; i < 4u; ++i)
+                patch[slot * 4u + i] = patch[last * 4u + i];
+            moved->mIndices = quad->mIndices;
+            quads[slot] = moved;
+        }
+        patch.resize(patch.size() - 4u);
+        quads.pop_back();
+    }
+    
+    // any pending changes are dropped, update skips the quad if it's still queued
+    quad->mPatchIndex = -1;
+    quad->mMovement = sf::Vector2f();
+    quad->mTexCoordsChanged = false;
+    mFreeQuads.push_back(quad);
+    
+    // vertices after the removed quad have moved within the merged vertices, so merge again
+    mMergeDirty = true;
+}
+
+void LayerSet::setPatch(const sf::Vector2u& patch, std::vector<sf::Vertex>& vertices)
+{
+    const sf::Uint32 index = patch.y * mPatchCount.x + patch.x;
+    assert(index < mPatches.size());
+    
+    mPatches[index].swap(vertices);
+    mPatchBounds[index] = sf::FloatRect();
+    updateAABB(index, mPatches[index].data(), mPatches[index].size());
+    mMergeDirty = true;
+}
+
+void LayerSet::clearPatch(const sf::Vector2u& patch)
+{
+    const sf::Uint32 index = patch.y * mPatchCount.x + patch.x;
+    assert(index < mPatches.size());
+    
+    // swap rather than clear so the memory is actually released
+    std::vector<sf::Vertex>().swap(mPatches[index]);
+    mPatchBounds[index] = sf::FloatRect();
+    mMergeDirty = true;
 }
 
-void LayerSet::updateAABB(sf::Vector2f position, sf::Vector2f size)
+void LayerSet::countDrawn(DrawStats& stats) const
 {
-    if(mBoundingBox.width == 0.f)
+    if(!mVisible) return;
+    
+    // counts exactly what draw submits
+    if(mMergePatches)
     {
-        // Not been set yet so take on initial size
-        mBoundingBox = sf::FloatRect(position, size);
+        if(mMergedVertices.empty()) return;
+        
+        ++stats.drawCalls;
+        stats.patches += mMergedPatches.size();
+        stats.vertices += mMergedVertices.size();
         return;
     }
     
-    if(position.x < mBoundingBox.left)
-        mBoundingBox.left = position.x;
-      
-    if(position.y < mBoundingBox.top)
-        mBoundingBox.top = position.y;
+    for(auto y = mVisibleRows.x; y <= mVisibleRows.y; ++y)
+    {
+        const sf::Vector2i& columns = mVisibleColumns[y - mVisibleRows.x];
+        for(auto x = columns.x; x <= columns.y; ++x)
+        {
+            const auto index = y * mPatchCount.x + x;
+            const auto& patch = mPatches[index];
+            if(patch.empty() || !mPatchBounds[index].intersects(mCullBounds)) continue;
+            
+            ++stats.drawCalls;
+            ++stats.patches;
+            stats.vertices += patch.size();
+        }
+    }
+}
+
+void LayerSet::writeCache(CacheWriter& writer) const
+{
+    // quad changes not yet applied by update aren't written
+    writer.write(mBoundingBox);
+    writer.write(static_cast<sf::Uint32>(mPatches.size()));
+    for(const auto& patch : mPatches)
+        writer.writeArray(patch);
+    
+    writer.write(static_cast<sf::Uint32>(mQuads.size()));
+    for(const auto& q : mQuads)
+    {
+        writer.write(q->mPatchIndex);
+        writer.write(q->mIndices);
+        writer.write(q->mGridIndex);
+    }
+}
+
+bool LayerSet::readCache(CacheReader& reader)
+{
+    sf::Uint32 patchCount = 0u;
+    if(!reader.read(mBoundingBox) || !reader.read(patchCount) || patchCount != mPatches.size())
+        return false;
+    
+    // patch bounds aren't cached, they're rebuilt from the vertices
+    std::size_t vertexCount = 0u;
+    for(sf::Uint32 i = 0u; i < mPatches.size(); ++i)
+    {
+        if(!reader.readArray(mPatches[i])) return false;
+        vertexCount += mPatches[i].size();
+        
+        mPatchBounds[i] = sf::FloatRect();
+        updateAABB(i, mPatches[i].data(), mPatches[i].size());
+    }
+    
+    // every quad owns four vertices, anything else means the cache is corrupt
+    sf::Uint32 quadCount = 0u;
+    if(!reader.read(quadCount) || quadCount * 4u != vertexCount) return false;
+    
+    mQuads.clear();
+    mQuads.reserve(quadCount);
+    for(auto& quads : mPatchQuads)
+        quads.clear();
+    for(sf::Uint32 i = 0u; i < quadCount; ++i)
+    {
+        sf::Int32 patchIndex = -1;
+        std::array<sf::Uint16, 4u> indices;
+        sf::Uint32 gridIndex = 0u;
+        if(!reader.read(patchIndex) || !reader.read(indices) || !reader.read(gridIndex)) return false;
         
-    if(size.x > mBoundingBox.width + std::fabs(mBoundingBox.left))
-        mBoundingBox.width = size.x + std::fabs(mBoundingBox.left);
+        if(patchIndex < 0 || static_cast<std::size_t>(patchIndex) >= mPatches.size()) return false;
+        for(const auto& index : indices)
+        {
+            if(index >= mPatches[patchIndex].size()) return false;
+        }
+        
+        // each quad must own a different group of four vertices
+        auto& quads = mPatchQuads[patchIndex];
+        const std::size_t slot = indices[0] / 4u;
+        quads.resize(mPatches[patchIndex].size() / 4u, nullptr);
+        if(indices[0] % 4u != 0u || quads[slot]) return false;
         
-    if(size.y > mBoundingBox.height + std::fabs(mBoundingBox.top))
-        mBoundingBox.height = size.y + std::fabs(mBoundingBox.top);
+        mQuads.emplace_back(TileQuad::Ptr(new TileQuad(indices[0], indices[1], indices[2], indices[3])));
+        mQuads.back()->mParentSet = this;
+        mQuads.back()->mPatchIndex = patchIndex;
+        mQuads.back()->mQuadIndex = i;
+        mQuads.back()->mGridIndex = gridIndex;
+        quads[slot] = mQuads.back().get();
+    }
+    mMergeDirty = true;
+    
+    return reader.good();
 }
 
-MapLayer::MapLayer(tmx::MapLayerType type)
+void LayerSet::draw(sf::RenderTarget& rt, sf::RenderStates states) const
+{
+    if(!mVisible) return;
+    
+    states.texture = &mTexture;
+    if(mMergePatches)
+    {
+        if(mMergedVertices.empty()) return;
+        
+        rt.draw(mMergedVertices.data(), static_cast<unsigned>(mMergedVertices.size()), sf::Quads, states);
+        return;
+    }
+    
+    for(auto y = mVisibleRows.x; y <= mVisibleRows.y; ++y)
+    {
+        const sf::Vector2i& columns = mVisibleColumns[y - mVisibleRows.x];
+        for(auto x = columns.x; x <= columns.y; ++x)
+        {
+            const auto index = y * mPatchCount.x + x;
+            const auto& patch = mPatches[index];
+            if(patch.empty() || !mPatchBounds[index].intersects(mCullBounds)) continue;
+            
+            rt.draw(patch.data(), static_cast<unsigned>(patch.size()), sf::Quads, states);
+        }
+    }
+}
+
+void LayerSet::updateAABB(sf::Uint32 patchIndex, const sf::Vertex* vertices, std::size_t count)
+{
+    if(count == 0u) return;
+    
+    // grow the patch bounds. a patch with no size has not been set yet so takes on the first vertex
+    sf::FloatRect& bounds = mPatchBounds[patchIndex];
+    sf::Vector2f min(bounds.left, bounds.top);
+    sf::Vector2f max(bounds.left + bounds.width, bounds.top + bounds.height);
+    if(bounds.width == 0.f && bounds.height == 0.f)
+        min = max = vertices[0].position;
+    
+    for(std::size_t i = 0u; i < count; ++i)
+    {
+        const sf::Vector2f& position = vertices[i].position;
+        min.x = std::min(min.x, position.x);
+        min.y = std::min(min.y, position.y);
+        max.x = std::max(max.x, position.x);
+        max.y = std::max(max.y, position.y);
+    }
+    bounds = sf::FloatRect(min, max - min);
+    
+    // and the bounds of the whole set
+    const sf::FloatRect oldBounds = mBoundingBox;
+    const sf::Vector2f oldSpill = mPatchSpill;
+    if(mBoundingBox.width == 0.f && mBoundingBox.height == 0.f)
+    {
+        mBoundingBox = bounds;
+    }
+    else
+    {
+        const float right = std::max(mBoundingBox.left + mBoundingBox.width, max.x);
+        const float bottom = std::max(mBoundingBox.top + mBoundingBox.height, max.y);
+        mBoundingBox.left = std::min(mBoundingBox.left, min.x);
+        mBoundingBox.top = std::min(mBoundingBox.top, min.y);
+        mBoundingBox.width = right - mBoundingBox.left;
+        mBoundingBox.height = bottom - mBoundingBox.top;
+    }
+    
+    // widen the cull spill if the patch now reaches outside its grid cells
+    const sf::Vector2i first((patchIndex % mPatchCount.x) * mPatchSize, (patchIndex / mPatchCount.x) * mPatchSize);
+    const sf::FloatRect cells = mLayout.gridBounds(first, first + sf::Vector2i(mPatchSize - 1, mPatchSize - 1));
+    mPatchSpill.x = std::max(mPatchSpill.x, std::max(cells.left - min.x, max.x - (cells.left + cells.width)));
+    mPatchSpill.y = std::max(mPatchSpill.y, std::max(cells.top - min.y, max.y - (cells.top + cells.height)));
+    
+    if(mBoundingBox != oldBounds || mPatchSpill != oldSpill) mBoundsGrown = true;
+}
+
+MapLayer::MapLayer(tmx::MapLayerType type, tmx::StringTable* strings)
  : opacity(1.f)
  , visible(true)
  , type(type)
+ , properties(strings)
  , mShader(nullptr)
 {}
 
@@ -145,6 +543,20 @@ void MapLayer::cull(const sf::FloatRect& bounds)
         ls.second->cull(bounds);
 }
 
+void MapLayer::update()
+{
+    for(auto& ls : layerSets)
+        ls.second->update();
+}
+
+void MapLayer::countDrawn(DrawStats& stats) const
+{
+    if(!visible) return;
+    
+    for(const auto& ls : layerSets)
+        ls.second->countDrawn(stats);
+}
+
 void MapLayer::draw(sf::RenderTarget& rt, sf::RenderStates states) const
 {
     if(!visible) return;
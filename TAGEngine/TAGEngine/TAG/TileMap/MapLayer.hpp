@@ -2,6 +2,7 @@
 
 // https://github.com/fallahn/sfml-tmxloader/blob/master/include/tmx/MapLayer.h
 #include "MapObject.hpp"
+#include "TileLayout.hpp"
 
 #include <SFML/Graphics/Drawable.hpp>
 #include <SFML/Graphics/Vertex.hpp>
@@ -13,20 +14,40 @@
 #include <map>
 
 class LayerSet;
+class CacheWriter;
+class CacheReader;
 class TileQuad final
 {
     friend class LayerSet;
 public:
     typedef std::unique_ptr<TileQuad> Ptr;
     TileQuad(sf::Uint16 i0, sf::Uint16 i1, sf::Uint16 i2, sf::Uint16 i3);
+    // changes are accumulated and applied to the vertices by the next LayerSet::update
     void move(const sf::Vector2f& distance);
+    // replaces the texture coords of the quad's four vertices, for example to animate a tile
+    void setTextureCoords(const std::array<sf::Vector2f, 4u>& coords);
     
 private:
     std::array<sf::Uint16, 4u> mIndices;
     sf::Vector2f mMovement;
+    std::array<sf::Vector2f, 4u> mTexCoords;
+    bool mTexCoordsChanged;
     LayerSet* mParentSet;
-    sf::Int32 mPatchIndex;
+    sf::Int32 mPatchIndex; // -1 once the quad's tile has been removed
+    sf::Uint32 mQuadIndex; // position in the parent set's quads
+    sf::Uint32 mGridIndex; // row order position of the quad's tile on the patch grid
     bool mDirty;
+    
+    void setDirty();
+};
+
+// counts of what a tile map submits when drawn, used to check culling is working
+struct DrawStats
+{
+    sf::Uint32 drawCalls;
+    sf::Uint32 patches;
+    sf::Uint32 vertices;
+    DrawStats();
 };
 
 // drawable composed of vertices representing a set of tiles on a layer
@@ -34,28 +55,90 @@ class LayerSet final : public sf::Drawable
 {
     friend class TileQuad;
 public:
-    LayerSet(const sf::Texture& texture, sf::Uint8 patchSize, const sf::Vector2u& mapSize, const sf::Vector2u tileSize);
+    LayerSet(const sf::Texture& texture, sf::Uint8 patchSize, const tmx::TileLayout& layout);
+    // adds the quad of the tile at grid position x, y to the patch containing it. Isometric and stepped
+    // sets keep each patch in grid order, which is back to front, so tiles which overlap the tiles behind
+    // them draw correctly. Orthogonal sets append, keeping the order tiles were added in.
     TileQuad* addTile(sf::Vertex vt0, sf::Vertex vt1, sf::Vertex vt2, sf::Vertex vt3, sf::Uint16 x, sf::Uint16 y);
     void cull(const sf::FloatRect& bounds);
+    // applies changes made to quads since the last update and rebuilds merged vertices if needed.
+    // call before drawing, drawing only reads the vertices.
+    void update();
+    
+    // returns the quad at the given index in the order quads were added, or nullptr
+    TileQuad* getQuad(sf::Uint32 index);
+    sf::Uint32 getQuadIndex(const TileQuad* quad) const;
+    
+    // rewrites the vertices of a tile in place, for a tile changed to another tile of this set
+    void setTileVertices(TileQuad* quad, const std::array<sf::Vertex, 4u>& vertices);
+    // removes a tile's vertices from its patch by moving the patch's last quad into its place, or in
+    // sorted sets by moving the quads after it down. The quad is kept for reuse by the next addTile
+    // so editing tiles doesn't allocate.
+    void removeTile(TileQuad* quad);
+    
+    // used when streaming. setPatch swaps the vertices of a streamed in chunk into the patch at the
+    // given patch coordinates, clearPatch releases them again. Streamed patches hold no quads.
+    void setPatch(const sf::Vector2u& patch, std::vector<sf::Vertex>& vertices);
+    void clearPatch(const sf::Vector2u& patch);
+    
+    // when enabled the visible patches are copied into a single vertex array drawn with one draw call.
+    // the array is only rebuilt when the visible patches change or their vertices are modified.
+    void setMergePatches(bool merge);
+    
+    // adds the draw calls, patches and vertices submitted by draw with the last cull to stats
+    void countDrawn(DrawStats& stats) const;
+    
+    // writes patch vertices and quads to the map cache, or restores them from it.
+    // readCache returns false if the cached data doesn't match this set's patch layout.
+    void writeCache(CacheWriter& writer) const;
+    bool readCache(CacheReader& reader);
 
 private:
     const sf::Texture& mTexture;
     const sf::Uint8 mPatchSize;
-    const sf::Vector2u mMapSize;
+    const tmx::TileLayout mLayout;
     const sf::Vector2u mPatchCount;
-    const sf::Vector2u mTileSize;
+    const bool mSorted; // patches are kept in grid order
     
     std::vector<TileQuad::Ptr> mQuads;
-    mutable std::vector<TileQuad*> mDirtyQuads;
+    std::vector<TileQuad*> mDirtyQuads;
+    std::vector<TileQuad*> mFreeQuads; // quads of removed tiles
+    std::vector<std::vector<TileQuad*>> mPatchQuads; // the quad owning each group of four vertices in a patch
     
-    sf::Vector2i mVisiblePatchStart, mVisiblePatchEnd;
-    mutable std::vector<std::vector<sf::Vertex>> mPatches;
+    // inclusive range of rows of patches which may overlap the culling bounds, and for each of those
+    // rows the inclusive range of columns which may
+    sf::Vector2i mVisibleRows;
+    std::vector<sf::Vector2i> mVisibleColumns;
+    sf::FloatRect mCullBounds;
+    std::vector<std::vector<sf::Vertex>> mPatches;
     
     void draw(sf::RenderTarget& rt, sf::RenderStates states) const;
     
-    mutable sf::FloatRect mBoundingBox;
-    void updateAABB(sf::Vector2f position, sf::Vector2f size);
+    bool mMergePatches;
+    bool mMergeDirty; // set when the merged vertices must be rebuilt from scratch
+    std::vector<sf::Uint32> mMergedPatches; // patches copied into mMergedVertices, in draw order
+    std::vector<sf::Int32> mMergedOffsets; // offset of each patch in mMergedVertices, -1 if not merged
+    std::vector<sf::Vertex> mMergedVertices;
+    std::vector<sf::Uint32> mVisiblePatches; // patches found visible by the last cull
+    // fills dest with the non empty patches overlapping the cull bounds
+    void collectVisiblePatches(std::vector<sf::Uint32>& dest) const;
+    void mergePatches();
+    // offset of a patch in mMergedVertices where its vertices can be patched in place, or -1
+    sf::Int32 getMergedOffset(sf::Uint32 patchIndex) const;
+    
+    // bounds of all vertices, and of the vertices in each patch. Empty patches have empty bounds.
+    // bounds only grow as quads move, so stay conservative until a patch is replaced.
+    sf::FloatRect mBoundingBox;
+    std::vector<sf::FloatRect> mPatchBounds;
+    // the furthest, in pixels, the vertices of any patch reach outside its own grid cells,
+    // for example with tiles larger than the map grid or tiles which have been moved
+    sf::Vector2f mPatchSpill;
+    // grows the bounds of a patch and the set to contain the given vertices
+    void updateAABB(sf::Uint32 patchIndex, const sf::Vertex* vertices, std::size_t count);
     bool mVisible;
+    // set when updateAABB grows the set bounds or patch spill, so the visibility found by the
+    // last cull may be stale. Tiles added or changed cull the set again if it's set.
+    bool mBoundsGrown;
 };
 
 // used to query the type of layer, for example when looking for layers containing collision objects.
@@ -82,18 +165,28 @@ public:
         All
     };
 
-    explicit MapLayer(tmx::MapLayerType layerType);
+    // properties are interned in strings, or the default string table when it's null
+    explicit MapLayer(tmx::MapLayerType layerType, tmx::StringTable* strings = nullptr);
     std::string name;
     float opacity;
     bool visible;
     MapTiles tiles;
     MapObjects objects;
     tmx::MapLayerType type;
-    std::map<std::string, std::string> properties;
+    tmx::PropertyList properties;
+    // tile gids of a tile layer, row by row. Used to build streamed chunks.
+    std::vector<sf::Uint32> gids;
 
     std::map<sf::Uint16, std::shared_ptr<LayerSet>> layerSets;
     void setShader(const sf::Shader& shader);
     void cull(const sf::FloatRect& bounds);
+    // applies any changes to the layer's tiles, see LayerSet::update
+    void update();
+    // adds what the layer submits when drawn to stats, see LayerSet::countDrawn
+    void countDrawn(DrawStats& stats) const;
+    
+    // the quad drawing each tile of a tile layer, built the first time a tile of the layer is edited
+    std::vector<TileQuad*> tileQuads;
     
 private:
     const sf::Shader* mShader;
@@ -1,8 +1,68 @@
 #include "MapObject.hpp"
 #include "MapLayer.hpp"
+#include "MapCache.hpp"
+#include "ObjectStore.hpp"
+#include "DebugShape.hpp"
 #include "Logger.hpp"
 #include "Trigonometry.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace
+{
+    // positive when a, b, c turn counter clockwise in a y up space
+    float turn(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& c)
+    {
+        return tag::crossProduct(b - a, c - b);
+    }
+    
+    bool inTriangle(const sf::Vector2f& p, const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& c, float sign)
+    {
+        return turn(a, b, p) * sign >= 0.f && turn(b, c, p) * sign >= 0.f && turn(c, a, p) * sign >= 0.f;
+    }
+    
+    // projects local hull points onto axis, then offsets the range by the object position
+    void project(const sf::Vector2f* points, sf::Uint16 count, const sf::Vector2f& position, const sf::Vector2f& axis, float& min, float& max)
+    {
+        min = max = tag::dotProduct(points[0], axis);
+        for(sf::Uint16 i = 1u; i < count; ++i)
+        {
+            const float d = tag::dotProduct(points[i], axis);
+            if(d < min) min = d;
+            else if(d > max) max = d;
+        }
+        const float offset = tag::dotProduct(position, axis);
+        min += offset;
+        max += offset;
+    }
+    
+    // narrows the times, as fractions of displacement, during which a moving box overlaps a hull's
+    // projection onto axis. Keeps the normal of the axis the box enters last. False if they never overlap.
+    bool sweepAxis(const sf::Vector2f& axis, float hullMin, float hullMax, const sf::Vector2f& centre, const sf::Vector2f& halfSize,
+                   const sf::Vector2f& displacement, float& enter, float& exit, sf::Vector2f& normal)
+    {
+        const float middle = tag::dotProduct(centre, axis);
+        const float radius = halfSize.x * std::abs(axis.x) + halfSize.y * std::abs(axis.y);
+        const float speed = tag::dotProduct(displacement, axis);
+        
+        if(speed == 0.f) return (middle + radius > hullMin && middle - radius < hullMax);
+        
+        float first = (hullMin - (middle + radius)) / speed;
+        float last = (hullMax - (middle - radius)) / speed;
+        if(first > last) std::swap(first, last);
+        
+        if(first > enter)
+        {
+            enter = first;
+            normal = (speed > 0.f) ? -axis : axis;
+        }
+        exit = std::min(exit, last);
+        return enter <= exit;
+    }
+}
+
 bool MapObject::Segment::intersects(const MapObject::Segment& segment)
 {
     sf::Vector2f s1 = end - start;
@@ -22,28 +82,27 @@ bool MapObject::Segment::intersects(const MapObject::Segment& segment)
     return false;
 }
 
-MapObject::MapObject()
- : mVisible(true)
+MapObject::MapObject(tmx::StringTable* strings)
+ : mName(tmx::EmptyString)
+ , mType(tmx::EmptyString)
+ , mParent(tmx::EmptyString)
+ , mProperties(strings)
+ , mVisible(true)
  , mShape(Rectangle)
  , mTileQuad(nullptr)
+ , mStore(nullptr)
+ , mId(0u)
  , mFurthestPoint(0.f)
 {}
 
-std::string MapObject::getPropertyString(const std::string& name)
+const std::string& MapObject::getPropertyString(const std::string& name) const
 {
-    if(mProperties.find(name) != mProperties.end())
-    {
-        return mProperties[name];
-    }
-    else
-    {
-        return std::string();
-    }
+    return mProperties.getString(name);
 }
 
 void MapObject::setProperty(const std::string& name, const std::string& value)
 {
-    mProperties[name] = value;
+    mProperties.set(name, value);
 }
 
 void MapObject::setPosition(float x, float y)
@@ -64,14 +123,9 @@ void MapObject::move(float x, float y)
 
 void MapObject::move(const sf::Vector2f& distance)
 {
-    // update properties by movement amount
+    // poly points, segments and hulls are relative to the position so only
+    // the world space values need updating
     mCentrePoint += distance;
-    for(auto& p : mPolypoints)
-    {
-        p += distance;
-    }
-    
-    mDebugShape.move(distance);
     
     mAABB.left += distance.x;
     mAABB.top += distance.y;
@@ -81,6 +135,8 @@ void MapObject::move(const sf::Vector2f& distance)
     
     // if object is of type tile move vertex data
     if(mTileQuad) mTileQuad->move(distance);
+    
+    if(mStore) mStore->update(mId);
 }
 
 bool MapObject::contains(sf::Vector2f point) const
@@ -111,53 +167,75 @@ bool MapObject::contains(sf::Vector2f point) const
 }
 
 bool MapObject::intersects(const MapObject& object) const
+{
+    sf::Vector2f normal;
+    float depth;
+    return intersects(object, normal, depth);
+}
+
+bool MapObject::intersects(const MapObject& object, sf::Vector2f& normal, float& depth) const
 {
     // check if distance between objects is less than sum of furthest points
-    float distance = tag::length(mCentrePoint + object.mCentrePoint);
-    if(distance > (mFurthestPoint + object.mFurthestPoint)) return false;
+    const float radius = mFurthestPoint + object.mFurthestPoint;
+    if(tag::squaredLength(object.mCentrePoint - mCentrePoint) > radius * radius) return false;
     
-    // check intersection if either object contains a point of the other
-    for(auto& p : object.mPolypoints)
-    {
-        if(contains(p + object.getPosition())) return true;
-    }
-    
-    for(auto& p : mPolypoints)
+    // the objects overlap if any pair of hulls do, report the deepest pair as the contact
+    bool result = false;
+    depth = 0.f;
+    for(const auto& a : mHulls)
     {
-        if(object.contains(p + getPosition())) return true;
+        for(const auto& b : object.mHulls)
+        {
+            sf::Vector2f hullNormal;
+            float hullDepth;
+            if(hullsOverlap(*this, a, object, b, hullNormal, hullDepth) && (!result || hullDepth > depth))
+            {
+                normal = hullNormal;
+                depth = hullDepth;
+                result = true;
+            }
+        }
     }
-    
-    return false;
+    return result;
 }
 
-void MapObject::createDebugShape(const sf::Color& color)
+void MapObject::createShape(const sf::Color& debugColor)
 {
     if(mPolypoints.size() == 0)
     {
-        LOG_ERR("Unable to create debug shape for <" + name + ">, object data missing.");
+        LOG_ERR("Unable to create shape for <" + getName() + ">, object data missing.");
         return;
     }
     
-    // reset any existing shapes incase new points have been added.
-    mDebugShape.reset();
-    
-    for(const auto& p : mPolypoints)
-    {
-        mDebugShape.addVertex(sf::Vertex(p, color));
-    }
-    
-    if(mShape != Polyline) mDebugShape.closeShape();
+    mDebugColor = debugColor;
     
     // precompute shape values for intersection testing
     calcTestValues();
+    createHulls();
     
     // create the AABB for quad tree testing
     createAABB();
+    
+    if(mStore) mStore->update(mId);
+}
+
+void MapObject::buildDebugShape(DebugShape& shape) const
+{
+    shape.reset();
+    for(const auto& p : mPolypoints)
+    {
+        shape.addVertex(sf::Vertex(p, mDebugColor));
+    }
+    
+    if(mShape != Polyline) shape.closeShape();
 }
 
 void MapObject::drawDebugShape(sf::RenderTarget& rt) const
 {
-    rt.draw(mDebugShape);
+    DebugShape shape;
+    buildDebugShape(shape);
+    shape.setPosition(mPosition);
+    rt.draw(shape);
 }
 
 sf::Vector2f MapObject::firstPoint() const
@@ -186,7 +264,8 @@ sf::Vector2f MapObject::lastPoint() const
 
 sf::Vector2f MapObject::collisionNormal(const sf::Vector2f& start, const sf::Vector2f& end) const
 {
-    Segment trajectory(start, end);
+    // segments are relative to the object position
+    Segment trajectory(start - mPosition, end - mPosition);
     sf::Vector2f dv = end - start;
     
     for(auto& s : mPolySegs)
@@ -202,17 +281,17 @@ sf::Vector2f MapObject::collisionNormal(const sf::Vector2f& start, const sf::Vec
             
             return tag::unitVector(n);
         }
-        
-        sf::Vector2f rv(end - start);
-        return tag::unitVector(rv);
     }
+    
+    sf::Vector2f rv(end - start);
+    return tag::unitVector(rv);
 }
 
 void MapObject::createSegments()
 {
     if(mPolypoints.size() == 0)
     {
-        LOG_ERR("Unable to create segments for object <" + mName + ">, object data missing.");
+        LOG_ERR("Unable to create segments for object <" + getName() + ">, object data missing.");
         return;
     }
     
@@ -222,7 +301,7 @@ void MapObject::createSegments()
     }
     mPolySegs.push_back(Segment(*(mPolypoints.end() - 1), *mPolypoints.begin()));
     
-    LOG_INF("Added " + std::to_string(mPolySegs.size()) + " segments to Map Object <" + mName +">");
+    LOG_INF("Added " + std::to_string(mPolySegs.size()) + " segments to Map Object <" + getName() +">");
 }
 
 bool MapObject::convex() const
@@ -274,6 +353,59 @@ void MapObject::setQuad(TileQuad* quad)
     mTileQuad = quad;
 }
 
+void MapObject::setStore(tmx::ObjectStore* store, sf::Uint32 id)
+{
+    mStore = store;
+    mId = id;
+}
+
+void MapObject::writeCache(CacheWriter& writer) const
+{
+    writer.write(getName());
+    writer.write(getType());
+    writer.write(getParent());
+    mProperties.writeCache(writer);
+    writer.write(mPosition);
+    writer.write(mSize);
+    writer.write(static_cast<sf::Uint8>(mVisible));
+    writer.write(static_cast<sf::Uint8>(mShape));
+    writer.write(mDebugColor);
+    writer.writeArray(mPolypoints);
+}
+
+bool MapObject::readCache(CacheReader& reader)
+{
+    std::string name, type, parent;
+    sf::Vector2f position;
+    sf::Uint8 visible = 0u, shape = 0u;
+    sf::Color debugColor;
+    std::vector<sf::Vector2f> points;
+    
+    if(!reader.read(name) || !reader.read(type) || !reader.read(parent) || !mProperties.readCache(reader)
+    || !reader.read(position) || !reader.read(mSize) || !reader.read(visible) || !reader.read(shape)
+    || !reader.read(debugColor) || !reader.readArray(points))
+        return false;
+    
+    if(shape > Tile) return false;
+    
+    setName(name);
+    setType(type);
+    setParent(parent);
+    
+    // points are cached as they were after loading, so set the position before adding them
+    setPosition(position);
+    setVisible(visible != 0u);
+    setShapeType(static_cast<MapObjectShape>(shape));
+    mPolypoints.swap(points);
+    
+    if(!mPolypoints.empty())
+    {
+        createShape(debugColor);
+        createSegments();
+    }
+    return true;
+}
+
 sf::Vector2f MapObject::calcCentre() const
 {
     if(mShape == Rectangle || mPolypoints.size() < 3)
@@ -327,17 +459,29 @@ sf::Vector2f MapObject::calcCentre() const
 void MapObject::calcTestValues()
 {
     mCentrePoint = calcCentre();
-    for(auto i = mPolypoints.cbegin(); i != mPolypoints.cend(); ++i)
+    mFurthestPoint = 0.f;
+    if(mPolypoints.empty()) return;
+    
+    // polyline centre ought to be half way between the start point and the furthest vertex
+    if(mShape == Polyline)
     {
-        float length = tag::length(*i - mCentrePoint);
-        if(mFurthestPoint < length)
+        sf::Vector2f furthest = mPolypoints[0];
+        float furthestLength = 0.f;
+        for(const auto& p : mPolypoints)
         {
-            mFurthestPoint = length;
-            if(mShape == Polyline) mCentrePoint = *i / 2.f;
+            const float length = tag::squaredLength(p - mPolypoints[0]);
+            if(furthestLength < length)
+            {
+                furthestLength = length;
+                furthest = p;
+            }
         }
+        mCentrePoint = mPosition + (mPolypoints[0] + furthest) / 2.f;
     }
-    // polyline centre ought to be half way between the start point and the furthest vertex
-    if(mShape == Polyline) mFurthestPoint /= 2.f;
+    
+    const sf::Vector2f centre = mCentrePoint - mPosition;
+    for(const auto& p : mPolypoints)
+        mFurthestPoint = std::max(mFurthestPoint, tag::length(p - centre));
 }
 
 void MapObject::createAABB()
@@ -367,4 +511,205 @@ void MapObject::createAABB()
         //mDebugShape.append(sf::Vector2f(mAABB.left + mAABB.width, mAABB.top + mAABB.height));
         //mDebugShape.append(sf::Vector2f(mAABB.left, mAABB.top + mAABB.height));
     }
+}
+
+void MapObject::createHulls()
+{
+    mHulls.clear();
+    mHullPoints.clear();
+    mHullAxes.clear();
+    
+    const sf::Uint16 count = static_cast<sf::Uint16>(mPolypoints.size());
+    if(count < 2u) return;
+    
+    std::vector<sf::Vector2f> points;
+    if(mShape == Polyline || count < 3u)
+    {
+        for(sf::Uint16 i = 0u; i + 1u < count; ++i)
+        {
+            points.assign(mPolypoints.begin() + i, mPolypoints.begin() + i + 2u);
+            addHull(points);
+        }
+        return;
+    }
+    
+    if(convex())
+    {
+        addHull(mPolypoints);
+        return;
+    }
+    
+    // clip ears off concave polygons until a single triangle remains. Winding is taken
+    // from the signed area so either direction of points can be split.
+    float area = 0.f;
+    for(sf::Uint16 i = 0u, j = count - 1u; i < count; j = i++)
+        area += tag::crossProduct(mPolypoints[j], mPolypoints[i]);
+    const float sign = (area < 0.f) ? -1.f : 1.f;
+    
+    std::vector<sf::Uint16> remaining(count);
+    for(sf::Uint16 i = 0u; i < count; ++i) remaining[i] = i;
+    
+    points.resize(3u);
+    while(remaining.size() > 3u)
+    {
+        bool clipped = false;
+        const std::size_t size = remaining.size();
+        for(std::size_t i = 0u; i < size && !clipped; ++i)
+        {
+            const sf::Vector2f& a = mPolypoints[remaining[(i + size - 1u) % size]];
+            const sf::Vector2f& b = mPolypoints[remaining[i]];
+            const sf::Vector2f& c = mPolypoints[remaining[(i + 1u) % size]];
+            
+            const float t = turn(a, b, c) * sign;
+            if(t < 0.f) continue;
+            
+            // collinear points add nothing to the shape so drop them without a triangle
+            if(t > 0.f)
+            {
+                bool ear = true;
+                for(const auto index : remaining)
+                {
+                    const sf::Vector2f& p = mPolypoints[index];
+                    if(p == a || p == b || p == c) continue;
+                    if(inTriangle(p, a, b, c, sign))
+                    {
+                        ear = false;
+                        break;
+                    }
+                }
+                if(!ear) continue;
+                
+                points[0] = a;
+                points[1] = b;
+                points[2] = c;
+                addHull(points);
+            }
+            remaining.erase(remaining.begin() + i);
+            clipped = true;
+        }
+        
+        // only self intersecting polygons run out of ears
+        if(!clipped)
+        {
+            LOG_WRN("Unable to split polygon object <" + getName() + "> into convex shapes, it may be self intersecting.");
+            break;
+        }
+    }
+    
+    if(remaining.size() == 3u)
+    {
+        for(std::size_t i = 0u; i < 3u; ++i) points[i] = mPolypoints[remaining[i]];
+        if(turn(points[0], points[1], points[2]) != 0.f) addHull(points);
+    }
+}
+
+void MapObject::addHull(const std::vector<sf::Vector2f>& points)
+{
+    Hull hull;
+    hull.first = static_cast<sf::Uint16>(mHullPoints.size());
+    hull.count = static_cast<sf::Uint16>(points.size());
+    hull.firstAxis = static_cast<sf::Uint16>(mHullAxes.size());
+    
+    mHullPoints.insert(mHullPoints.end(), points.begin(), points.end());
+    if(points.size() == 2u)
+    {
+        // a segment needs its direction as well as its normal to separate it from collinear shapes
+        const sf::Vector2f edge = points[1] - points[0];
+        if(edge == sf::Vector2f()) return;
+        
+        mHullAxes.push_back(tag::unitVector(tag::perpendicularVector(edge)));
+        mHullAxes.push_back(tag::unitVector(edge));
+    }
+    else
+    {
+        for(std::size_t i = 0u; i < points.size(); ++i)
+        {
+            const sf::Vector2f edge = points[(i + 1u) % points.size()] - points[i];
+            if(edge != sf::Vector2f()) mHullAxes.push_back(tag::unitVector(tag::perpendicularVector(edge)));
+        }
+    }
+    hull.axisCount = static_cast<sf::Uint16>(mHullAxes.size() - hull.firstAxis);
+    mHulls.push_back(hull);
+}
+
+bool MapObject::hullsOverlap(const MapObject& objectA, const Hull& a, const MapObject& objectB, const Hull& b, sf::Vector2f& normal, float& depth)
+{
+    const sf::Vector2f* pointsA = &objectA.mHullPoints[a.first];
+    const sf::Vector2f* pointsB = &objectB.mHullPoints[b.first];
+    depth = std::numeric_limits<float>::max();
+    
+    // test the edge normals of both hulls, any axis where the projections don't overlap separates them
+    for(int i = 0; i < 2; ++i)
+    {
+        const Hull& hull = (i == 0) ? a : b;
+        const sf::Vector2f* axes = (i == 0) ? objectA.mHullAxes.data() : objectB.mHullAxes.data();
+        for(sf::Uint16 j = hull.firstAxis, end = hull.firstAxis + hull.axisCount; j < end; ++j)
+        {
+            const sf::Vector2f& axis = axes[j];
+            float minA, maxA, minB, maxB;
+            project(pointsA, a.count, objectA.mPosition, axis, minA, maxA);
+            project(pointsB, b.count, objectB.mPosition, axis, minB, maxB);
+            
+            // b is pushed out along whichever direction needs the least movement
+            const float forward = maxA - minB;
+            const float backward = maxB - minA;
+            const float overlap = std::min(forward, backward);
+            if(overlap <= 0.f) return false;
+            
+            if(overlap < depth)
+            {
+                depth = overlap;
+                normal = (forward < backward) ? axis : -axis;
+            }
+        }
+    }
+    return true;
+}
+
+bool MapObject::sweep(const sf::FloatRect& box, const sf::Vector2f& displacement, float& time, sf::Vector2f& normal) const
+{
+    // hulls are in local space so move the box there rather than the hulls to the box
+    const sf::Vector2f halfSize(box.width / 2.f, box.height / 2.f);
+    const sf::Vector2f centre(box.left + halfSize.x - mPosition.x, box.top + halfSize.y - mPosition.y);
+    
+    bool result = false;
+    for(const auto& hull : mHulls)
+    {
+        float hullTime;
+        sf::Vector2f hullNormal;
+        if(sweepHull(hull, centre, halfSize, displacement, hullTime, hullNormal) && (!result || hullTime < time))
+        {
+            time = hullTime;
+            normal = hullNormal;
+            result = true;
+        }
+    }
+    return result;
+}
+
+bool MapObject::sweepHull(const Hull& hull, const sf::Vector2f& centre, const sf::Vector2f& halfSize, const sf::Vector2f& displacement, float& time, sf::Vector2f& normal) const
+{
+    const sf::Vector2f* points = &mHullPoints[hull.first];
+    float enter = -std::numeric_limits<float>::max();
+    float exit = std::numeric_limits<float>::max();
+    float hullMin, hullMax;
+    
+    // the edge normals of the hull and the sides of the box are enough to separate them
+    for(sf::Uint16 i = hull.firstAxis, end = hull.firstAxis + hull.axisCount; i < end; ++i)
+    {
+        project(points, hull.count, sf::Vector2f(), mHullAxes[i], hullMin, hullMax);
+        if(!sweepAxis(mHullAxes[i], hullMin, hullMax, centre, halfSize, displacement, enter, exit, normal)) return false;
+    }
+    
+    const sf::Vector2f boxAxes[] = { sf::Vector2f(1.f, 0.f), sf::Vector2f(0.f, 1.f) };
+    for(const auto& axis : boxAxes)
+    {
+        project(points, hull.count, sf::Vector2f(), axis, hullMin, hullMax);
+        if(!sweepAxis(axis, hullMin, hullMax, centre, halfSize, displacement, enter, exit, normal)) return false;
+    }
+    
+    // entering before the start means the box already overlaps the hull
+    if(enter < 0.f || enter > 1.f) return false;
+    time = enter;
+    return true;
 }
\ No newline at end of file
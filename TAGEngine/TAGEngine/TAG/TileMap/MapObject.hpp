@@ -2,7 +2,7 @@
 
 #include "VectorAlgebra2D.hpp"
 //#include "MathFuncs.hpp"
-#include "DebugShape.hpp"
+#include "PropertyList.hpp"
 
 #include <SFML/Graphics/Color.hpp>
 #include <SFML/Graphics/Drawable.hpp>
@@ -24,6 +24,13 @@
 #include <memory>
 
 class TileQuad;
+class DebugShape;
+class CacheWriter;
+class CacheReader;
+namespace tmx
+{
+    class ObjectStore;
+}
 
 enum MapObjectShape
 {
@@ -51,12 +58,26 @@ private:
         sf::Vector2f start;
         sf::Vector2f end;
     };
+    
+    // a convex piece of the object's shape used for SAT testing. Indexes a run of
+    // mHullPoints and mHullAxes, polyline segments are stored as two point hulls.
+    struct Hull
+    {
+        sf::Uint16 first;
+        sf::Uint16 count;
+        sf::Uint16 firstAxis;
+        sf::Uint16 axisCount;
+    };
   
 public:
-    MapObject();
+    // names and properties are interned in strings, or the default string table when it's null
+    explicit MapObject(tmx::StringTable* strings = nullptr);
     
     // Returns empty string if property not found.
-    std::string getPropertyString(const std::string& name);
+    const std::string& getPropertyString(const std::string& name) const;
+    
+    // returns the object's custom properties, parsed for reading as numbers, booleans or colours
+    const tmx::PropertyList& getProperties() const { return mProperties; }
     
     // returns top left corner of bounding rectangle.
     sf::Vector2f getPosition() const { return mPosition; }
@@ -64,17 +85,25 @@ public:
     // returns precomputed centre of mass, or zero for polylines.
     sf::Vector2f getCentre() const { return mCentrePoint; }
     
+    // returns the radius around the centre which contains every point of the object
+    float getRadius() const { return mFurthestPoint; }
+    
     // returns the type of shape of the object.
     MapObjectShape getShapeType() const { return mShape; }
     
     // returns the object's name
-    std::string getName() const { return mName; }
+    const std::string& getName() const { return mProperties.getStrings().get(mName); }
     
     // returns the object's type
-    std::string getType() const { return mType; }
+    const std::string& getType() const { return mProperties.getStrings().get(mType); }
     
     // returns the name of the object's parent layer
-    std::string getParent() const { return mParent;  }
+    const std::string& getParent() const { return mProperties.getStrings().get(mParent); }
+    
+    // handles of the above in the object's string table, for comparing without the strings
+    tmx::StringId getNameId() const { return mName; }
+    tmx::StringId getTypeId() const { return mType; }
+    tmx::StringId getParentId() const { return mParent; }
     
     // Returns the objects AABB in world coordinates
     sf::FloatRect getAABB() const { return mAABB; }
@@ -97,13 +126,13 @@ public:
     void setSize(const sf::Vector2f& size) { mSize = size; }
     
     // sets the object's name
-    void setName(const std::string& name) { mName = name;  }
+    void setName(const std::string& name) { mName = mProperties.getStrings().intern(name); }
     
     // sets the object's type
-    void setType(const std::string& type) { mType = type; }
+    void setType(const std::string& type) { mType = mProperties.getStrings().intern(type); }
     
     // sets the object's parent layer
-    void setParent(const std::string& parent) { mParent = parent; }
+    void setParent(const std::string& parent) { mParent = mProperties.getStrings().intern(parent); }
     
     // sets the shape type
     void setShapeType(MapObjectShape shape) { mShape = shape; }
@@ -111,8 +140,8 @@ public:
     // sets the visiblity
     void setVisible(bool visible) { mVisible = visible; }
     
-    // Adds a point to the list of polygon points. If calling this manually
-    // call createDebugShape() afterwards to rebuild debug output
+    // Adds a point to the list of polygon points, relative to the object position. If calling
+    // this manually call createShape() afterwards to rebuild the test values
     void addPoint(const sf::Vector2f& point) { mPolypoints.push_back(point); }
     
     // checks if an object contains given point in world coords.
@@ -122,10 +151,25 @@ public:
     // checks if two objects intersect, including polylines.
     bool intersects(const MapObject& object) const;
     
-    // creates a shape used for debug drawing - points are in world space
-    void createDebugShape(const sf::Color& color);
+    // as above, and on intersection returns the unit normal pointing from this object towards
+    // the other and the depth of penetration along it. Moving the other object by normal * depth
+    // separates them. Concave polygons are tested as the triangles they are split into.
+    bool intersects(const MapObject& object, sf::Vector2f& normal, float& depth) const;
+    
+    // moves box by displacement and returns the fraction of the displacement moved before touching
+    // the object, from 0 to 1, and the normal of the surface touched. A box already overlapping the
+    // object is never stopped by it, so it can always move out. Use a box with no size to sweep a point.
+    bool sweep(const sf::FloatRect& box, const sf::Vector2f& displacement, float& time, sf::Vector2f& normal) const;
+    
+    // precomputes the centre, AABB and convex hulls used for intersection testing from the
+    // poly points, and sets the colour of the object's outline when it's debug drawn
+    void createShape(const sf::Color& debugColor);
     
-    // draws debug shape to given target
+    // fills shape with the outline of the object relative to its position. Debug geometry is
+    // only built when it's drawn, the map keeps the shapes of its objects in tmx::DebugDraw.
+    void buildDebugShape(DebugShape& shape) const;
+    
+    // draws debug shape to given target, building it each time
     void drawDebugShape(sf::RenderTarget& rt) const;
     
     // returns the first point of poly point member (if any)
@@ -144,7 +188,7 @@ public:
     // returns if an object poly shape is convex or not.
     bool convex() const;
     
-    // returns a reference to the array of points making up the object
+    // returns a reference to the array of points making up the object, relative to its position
     const std::vector<sf::Vector2f>& polyPoints() const;
     
     // reversing winding of object points
@@ -153,19 +197,41 @@ public:
     // sets the quad usef to draw the tile for tile objects.
     void setQuad(TileQuad* quad);
     
+    // returns the quad used to draw tile objects, or nullptr
+    TileQuad* getQuad() const { return mTileQuad; }
+    
+    // set by the store holding the object's query data, which the object keeps up to date as it moves.
+    // Like the tile quad the store isn't owned, so copies of the object update the same entry.
+    void setStore(tmx::ObjectStore* store, sf::Uint32 id);
+    
+    // returns the object's id in the map's object store
+    sf::Uint32 getId() const { return mId; }
+    
+    // writes the object to the map cache, or restores it from the cache and
+    // rebuilds the shape and segments. The tile quad is not cached.
+    void writeCache(CacheWriter& writer) const;
+    bool readCache(CacheReader& reader);
+    
 private:
     // object properties, reflect those which are part of the tmx format.
-    std::string mName, mType, mParent; // parent is the name of layer to which the object belongs.
+    tmx::StringId mName, mType, mParent; // parent is the name of layer to which the object belongs.
     sf::Vector2f mPosition, mSize;
-    std::map<std::string, std::string> mProperties; // map of custom name/value properties.
+    tmx::PropertyList mProperties; // custom name/value properties, and the table the names are interned in
     bool mVisible;
     std::vector<sf::Vector2f> mPolypoints;
     MapObjectShape mShape;
-    DebugShape mDebugShape;
+    sf::Color mDebugColor;
     sf::Vector2f mCentrePoint;
     
     std::vector<Segment> mPolySegs; // segments which make up shape, if any
     TileQuad* mTileQuad;
+    tmx::ObjectStore* mStore;
+    sf::Uint32 mId;
+    
+    // convex pieces of the shape in local space, so moving the object never touches them
+    std::vector<Hull> mHulls;
+    std::vector<sf::Vector2f> mHullPoints;
+    std::vector<sf::Vector2f> mHullAxes; // unit edge normals of each hull
     
     // The furthest distance from centre of object to vertex - used for intersection testing
     // AABB created from polygonal shapes, used for adding MapObjects to a QuadTreeNode.
@@ -183,6 +249,16 @@ private:
     
     // creates an AABB around the object based on its polygonal points, in world space
     void createAABB();
+    
+    // splits the poly points into convex hulls, triangulating concave polygons
+    void createHulls();
+    void addHull(const std::vector<sf::Vector2f>& points);
+    
+    // separating axis test of one hull from each object. Returns false if an axis separates them,
+    // else the axis of least overlap, pointing from a to b, and the overlap along it
+    static bool hullsOverlap(const MapObject& objectA, const Hull& a, const MapObject& objectB, const Hull& b, sf::Vector2f& normal, float& depth);
+    // swept separating axis test of a moving box, given by its centre in local space, against one hull
+    bool sweepHull(const Hull& hull, const sf::Vector2f& centre, const sf::Vector2f& halfSize, const sf::Vector2f& displacement, float& time, sf::Vector2f& normal) const;
 };
 typedef std::vector<MapObject> MapObjects;
     
@@ -0,0 +1,117 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+ : mData(nullptr)
+ , mSize(0u)
+ , mMode(ReadOnly)
+#ifdef _WIN32
+ , mFile(nullptr)
+ , mMapping(nullptr)
+#endif
+{}
+
+MappedFile::MappedFile(const std::string& path, Mode mode)
+ : MappedFile()
+{
+    open(path, mode);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path, Mode mode)
+{
+    close();
+    
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) return false;
+    
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    
+    HANDLE mapping = CreateFileMappingA(file, nullptr, (mode == CopyOnWrite) ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+    if(!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    
+    void* view = MapViewOfFile(mapping, (mode == CopyOnWrite) ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    if(!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    
+    mFile = file;
+    mMapping = mapping;
+    mData = static_cast<char*>(view);
+    mSize = static_cast<std::size_t>(size.QuadPart);
+    mMode = mode;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(mData) UnmapViewOfFile(mData);
+    if(mMapping) CloseHandle(mMapping);
+    if(mFile) CloseHandle(mFile);
+    
+    mData = nullptr;
+    mSize = 0u;
+    mMapping = nullptr;
+    mFile = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& path, Mode mode)
+{
+    close();
+    
+    int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0) return false;
+    
+    struct stat info;
+    if(fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+    
+    // private mappings are copy on write, so writable pages are only copied when modified.
+    // the mapping holds its own reference to the file so the descriptor can be closed straight away
+    const int protection = (mode == CopyOnWrite) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size), protection, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if(view == MAP_FAILED) return false;
+    
+    mData = static_cast<char*>(view);
+    mSize = static_cast<std::size_t>(info.st_size);
+    mMode = mode;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(mData) munmap(mData, mSize);
+    
+    mData = nullptr;
+    mSize = 0u;
+}
+#endif
\ No newline at end of file
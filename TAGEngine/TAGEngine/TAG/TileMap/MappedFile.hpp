@@ -0,0 +1,46 @@
+#pragma once
+
+// Memory mapping of a file. The whole file is mapped on open and unmapped when the
+// object is destroyed, so pointers returned by data() are only valid for the lifetime
+// of the MappedFile. Files can be mapped read only, or copy on write, which allows the
+// mapped data to be modified in place (for example by an in situ parser) without the
+// changes ever being written back to disk.
+
+#include <SFML/System/NonCopyable.hpp>
+
+#include <string>
+#include <cstddef>
+
+class MappedFile final : private sf::NonCopyable
+{
+public:
+    enum Mode
+    {
+        ReadOnly,
+        CopyOnWrite
+    };
+    
+    MappedFile();
+    explicit MappedFile(const std::string& path, Mode mode = ReadOnly);
+    ~MappedFile();
+    
+    // maps the given file, closing any currently mapped file first. Returns false on failure.
+    bool open(const std::string& path, Mode mode = ReadOnly);
+    void close();
+    
+    bool isOpen() const { return mData != nullptr; }
+    const char* data() const { return mData; }
+    std::size_t size() const { return mSize; }
+    
+    // returns writable data for files opened CopyOnWrite, else nullptr
+    char* mutableData() { return (mMode == CopyOnWrite) ? mData : nullptr; }
+    
+private:
+    char* mData;
+    std::size_t mSize;
+    Mode mMode;
+#ifdef _WIN32
+    void* mFile;
+    void* mMapping;
+#endif
+};
\ No newline at end of file
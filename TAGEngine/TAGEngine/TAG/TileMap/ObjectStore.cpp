@@ -0,0 +1,79 @@
+#include "ObjectStore.hpp"
+#include "MapLayer.hpp"
+
+namespace tmx
+{
+    void ObjectStore::build(std::vector<MapLayer>& layers)
+    {
+        clear();
+        
+        std::size_t count = 0u;
+        for(const auto& layer : layers) count += layer.objects.size();
+        mAABBs.reserve(count);
+        mCentres.reserve(count);
+        mRadii.reserve(count);
+        mShapes.reserve(count);
+        mObjects.reserve(count);
+        mLayerStarts.reserve(layers.size() + 1u);
+        
+        for(auto& layer : layers)
+        {
+            mLayerStarts.push_back(static_cast<sf::Uint32>(mObjects.size()));
+            for(auto& object : layer.objects)
+            {
+                const sf::Uint32 id = static_cast<sf::Uint32>(mObjects.size());
+                mObjects.push_back(&object);
+                mAABBs.push_back(object.getAABB());
+                mCentres.push_back(object.getCentre());
+                mRadii.push_back(object.getRadius());
+                mShapes.push_back(static_cast<sf::Uint8>(object.getShapeType()));
+                object.setStore(this, id);
+            }
+        }
+        mLayerStarts.push_back(static_cast<sf::Uint32>(mObjects.size()));
+    }
+    
+    void ObjectStore::clear()
+    {
+        for(auto object : mObjects) object->setStore(nullptr, 0u);
+        
+        mAABBs.clear();
+        mCentres.clear();
+        mRadii.clear();
+        mShapes.clear();
+        mObjects.clear();
+        mLayerStarts.clear();
+    }
+    
+    std::pair<sf::Uint32, sf::Uint32> ObjectStore::getLayerRange(sf::Uint16 layer) const
+    {
+        if(layer + 1u >= mLayerStarts.size()) return std::make_pair(0u, 0u);
+        return std::make_pair(mLayerStarts[layer], mLayerStarts[layer + 1u] - mLayerStarts[layer]);
+    }
+    
+    void ObjectStore::query(const sf::FloatRect& area, std::vector<sf::Uint32>& ids, sf::Uint32 first, sf::Uint32 count) const
+    {
+        const sf::Uint32 end = (count == 0u) ? static_cast<sf::Uint32>(mAABBs.size()) : first + count;
+        const float right = area.left + area.width;
+        const float bottom = area.top + area.height;
+        
+        for(sf::Uint32 id = first; id < end; ++id)
+        {
+            const sf::FloatRect& aabb = mAABBs[id];
+            if(area.left <= aabb.left + aabb.width && aabb.left <= right
+               && area.top <= aabb.top + aabb.height && aabb.top <= bottom)
+            {
+                ids.push_back(id);
+            }
+        }
+    }
+    
+    void ObjectStore::update(sf::Uint32 id)
+    {
+        const MapObject& object = *mObjects[id];
+        mAABBs[id] = object.getAABB();
+        mCentres[id] = object.getCentre();
+        mRadii[id] = object.getRadius();
+        mShapes[id] = static_cast<sf::Uint8>(object.getShapeType());
+    }
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+// The data queries need from every object of a map, packed into arrays indexed by object id so
+// scanning them for culling or building the quad tree doesn't pull whole MapObjects into the cache.
+// The MapObjects in each layer are the side table of cold data - points, hulls, debug shape and
+// properties - and are only touched once a query has narrowed down the objects it needs.
+//
+// Ids are given out layer by layer in draw order, so the objects of one layer are a range of ids.
+// Objects write their new bounds back to the store whenever they move.
+
+#include "MapObject.hpp"
+
+#include <SFML/Graphics/Rect.hpp>
+
+#include <vector>
+#include <utility>
+
+class MapLayer;
+
+namespace tmx
+{
+    class ObjectStore final
+    {
+    public:
+        // assigns ids to the objects of every layer and copies their query data. The layers'
+        // object vectors must not be resized until the store is rebuilt or cleared.
+        void build(std::vector<MapLayer>& layers);
+        void clear();
+        
+        std::size_t size() const { return mObjects.size(); }
+        
+        const sf::FloatRect& getAABB(sf::Uint32 id) const { return mAABBs[id]; }
+        const sf::Vector2f& getCentre(sf::Uint32 id) const { return mCentres[id]; }
+        float getRadius(sf::Uint32 id) const { return mRadii[id]; }
+        MapObjectShape getShape(sf::Uint32 id) const { return static_cast<MapObjectShape>(mShapes[id]); }
+        MapObject& getObject(sf::Uint32 id) const { return *mObjects[id]; }
+        
+        // first id and number of objects of a layer
+        std::pair<sf::Uint32, sf::Uint32> getLayerRange(sf::Uint16 layer) const;
+        
+        // appends the ids of objects from first to first + count whose AABB touches area, including
+        // areas with no width or height. All objects are tested when count is 0.
+        void query(const sf::FloatRect& area, std::vector<sf::Uint32>& ids, sf::Uint32 first = 0u, sf::Uint32 count = 0u) const;
+        
+        // copies the query data of an object again after it has changed
+        void update(sf::Uint32 id);
+        
+    private:
+        std::vector<sf::FloatRect> mAABBs;
+        std::vector<sf::Vector2f> mCentres;
+        std::vector<float> mRadii;
+        std::vector<sf::Uint8> mShapes;
+        std::vector<MapObject*> mObjects;
+        std::vector<sf::Uint32> mLayerStarts; // first id of each layer, followed by the number of objects
+    };
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "PropertyList.hpp"
+#include "MapCache.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cerrno>
+
+namespace
+{
+    // true if the whole of str was read as a number
+    bool parsed(const char* str, const char* end)
+    {
+        return end != str && *end == '\0' && errno == 0;
+    }
+    
+    void parseValue(const std::string& value, tmx::Property& property)
+    {
+        property.types = 0u;
+        property.intValue = 0;
+        property.floatValue = 0.f;
+        property.boolValue = false;
+        property.colourValue = sf::Color();
+        if(value.empty()) return;
+        
+        const char* str = value.c_str();
+        char* end = nullptr;
+        
+        errno = 0;
+        const long integer = std::strtol(str, &end, 10);
+        if(parsed(str, end))
+        {
+            property.intValue = static_cast<sf::Int32>(integer);
+            property.types |= tmx::Property::Int;
+        }
+        
+        errno = 0;
+        const float number = std::strtof(str, &end);
+        if(parsed(str, end))
+        {
+            property.floatValue = number;
+            property.types |= tmx::Property::Float;
+            if(!(property.types & tmx::Property::Int)) property.intValue = static_cast<sf::Int32>(number);
+            
+            property.boolValue = (number != 0.f);
+            property.types |= tmx::Property::Bool;
+        }
+        else if(value == "true" || value == "false")
+        {
+            property.boolValue = (value == "true");
+            property.types |= tmx::Property::Bool;
+        }
+        
+        // tiled writes colours as #AARRGGBB, older versions and the map colours as #RRGGBB
+        if(value[0] == '#' && (value.size() == 7u || value.size() == 9u))
+        {
+            errno = 0;
+            const unsigned long argb = std::strtoul(str + 1, &end, 16);
+            if(parsed(str + 1, end))
+            {
+                const sf::Uint8 alpha = (value.size() == 9u) ? static_cast<sf::Uint8>(argb >> 24) : 255u;
+                property.colourValue = sf::Color((argb >> 16) & 0xff, (argb >> 8) & 0xff, argb & 0xff, alpha);
+                property.types |= tmx::Property::Colour;
+            }
+        }
+    }
+    
+    bool byName(const tmx::Property& property, tmx::StringId name)
+    {
+        return property.name < name;
+    }
+}
+
+namespace tmx
+{
+    PropertyList::PropertyList(StringTable* strings)
+     : mStrings(strings ? strings : &defaultStringTable())
+    {}
+    
+    void PropertyList::set(const std::string& name, const std::string& value)
+    {
+        const StringId id = mStrings->intern(name);
+        auto result = std::lower_bound(mProperties.begin(), mProperties.end(), id, byName);
+        if(result == mProperties.end() || result->name != id)
+        {
+            result = mProperties.insert(result, Property());
+            result->name = id;
+        }
+        result->value = mStrings->intern(value);
+        parseValue(value, *result);
+    }
+    
+    const Property* PropertyList::find(StringId name) const
+    {
+        auto result = std::lower_bound(mProperties.begin(), mProperties.end(), name, byName);
+        return (result == mProperties.end() || result->name != name) ? nullptr : &*result;
+    }
+    
+    const Property* PropertyList::find(const std::string& name) const
+    {
+        // a name which was never interned can't be the name of a property
+        const StringId id = mStrings->find(name);
+        return (id == InvalidString) ? nullptr : find(id);
+    }
+    
+    const std::string& PropertyList::getString(const std::string& name) const
+    {
+        const Property* property = find(name);
+        return mStrings->get(property ? property->value : EmptyString);
+    }
+    
+    sf::Int32 PropertyList::getInt(const std::string& name, sf::Int32 fallback) const
+    {
+        const Property* property = find(name);
+        return (property && (property->types & Property::Float)) ? property->intValue : fallback;
+    }
+    
+    float PropertyList::getFloat(const std::string& name, float fallback) const
+    {
+        const Property* property = find(name);
+        return (property && (property->types & Property::Float)) ? property->floatValue : fallback;
+    }
+    
+    bool PropertyList::getBool(const std::string& name, bool fallback) const
+    {
+        const Property* property = find(name);
+        return (property && (property->types & Property::Bool)) ? property->boolValue : fallback;
+    }
+    
+    sf::Color PropertyList::getColour(const std::string& name, const sf::Color& fallback) const
+    {
+        const Property* property = find(name);
+        return (property && (property->types & Property::Colour)) ? property->colourValue : fallback;
+    }
+    
+    void PropertyList::writeCache(CacheWriter& writer) const
+    {
+        // same layout as a cached std::map of properties
+        writer.write(static_cast<sf::Uint32>(mProperties.size()));
+        for(const auto& property : mProperties)
+        {
+            writer.write(mStrings->get(property.name));
+            writer.write(mStrings->get(property.value));
+        }
+    }
+    
+    bool PropertyList::readCache(CacheReader& reader)
+    {
+        sf::Uint32 count = 0u;
+        if(!reader.read(count)) return false;
+        
+        mProperties.clear();
+        std::string name, value;
+        for(sf::Uint32 i = 0u; i < count; ++i)
+        {
+            if(!reader.read(name) || !reader.read(value)) return false;
+            set(name, value);
+        }
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+// Custom name/value properties of a map object or layer. Names and values are interned in a
+// StringTable and kept in a flat array sorted by name handle, so a lookup is a binary search
+// over integers. Each value is parsed into every type it can be read as when it's set, so the
+// typed getters don't parse strings.
+
+#include "StringTable.hpp"
+
+#include <SFML/Graphics/Color.hpp>
+
+#include <string>
+#include <vector>
+
+class CacheWriter;
+class CacheReader;
+
+namespace tmx
+{
+    struct Property
+    {
+        // the types a value could be parsed as
+        enum Type
+        {
+            Int = 0x1,
+            Float = 0x2,
+            Bool = 0x4,
+            Colour = 0x8
+        };
+        
+        StringId name;
+        StringId value;
+        sf::Int32 intValue;
+        float floatValue;
+        sf::Color colourValue; // from #RRGGBB or #AARRGGBB
+        bool boolValue; // from true, false or a number
+        sf::Uint8 types;
+    };
+    
+    class PropertyList final
+    {
+    public:
+        // uses the default string table when strings is null
+        explicit PropertyList(StringTable* strings = nullptr);
+        
+        // sets a property value, or adds it if the property doesn't exist
+        void set(const std::string& name, const std::string& value);
+        
+        // returns nullptr if there's no such property
+        const Property* find(StringId name) const;
+        const Property* find(const std::string& name) const;
+        
+        // return fallback if the property doesn't exist or its value isn't of the type asked for.
+        // getInt reads any number, truncating those with a fractional part.
+        const std::string& getString(const std::string& name) const;
+        sf::Int32 getInt(const std::string& name, sf::Int32 fallback = 0) const;
+        float getFloat(const std::string& name, float fallback = 0.f) const;
+        bool getBool(const std::string& name, bool fallback = false) const;
+        sf::Color getColour(const std::string& name, const sf::Color& fallback = sf::Color()) const;
+        
+        // sorted by name handle, not alphabetically
+        const std::vector<Property>& getProperties() const { return mProperties; }
+        StringTable& getStrings() const { return *mStrings; }
+        bool empty() const { return mProperties.empty(); }
+        void clear() { mProperties.clear(); }
+        
+        // cached as name/value string pairs, values are parsed again when read
+        void writeCache(CacheWriter& writer) const;
+        bool readCache(CacheReader& reader);
+        
+    private:
+        StringTable* mStrings;
+        std::vector<Property> mProperties;
+    };
+}
\ No newline at end of file
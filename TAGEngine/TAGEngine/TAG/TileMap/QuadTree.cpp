@@ -5,13 +5,9 @@ QuadTreeNode::QuadTreeNode(sf::Uint16 level, const sf::FloatRect& bounds)
  , MaxLevels(5u)
  , mLevel(level)
  , mBounds(bounds)
+ , mSearched(false)
 {
     mChildren.reserve(4);
-    mDebugShape = sf::RectangleShape(sf::Vector2f(bounds.width, bounds.height));
-    mDebugShape.setPosition(bounds.left, bounds.top);
-    mDebugShape.setFillColor(sf::Color::Transparent);
-    mDebugShape.setOutlineColor(sf::Color::Green);
-    mDebugShape.setOutlineThickness(-2.f);
 }
 
 void QuadTreeRoot::clear(const sf::FloatRect& newBounds)
@@ -19,8 +15,7 @@ void QuadTreeRoot::clear(const sf::FloatRect& newBounds)
     mObjects.clear();
     mChildren.clear();
     mBounds = newBounds;
-    mDebugShape.setPosition(newBounds.left, newBounds.top);
-    mDebugShape.setSize(sf::Vector2f(newBounds.width, newBounds.height));
+    mSearched = false;
     
     mSearchDepth = 0;
     mDepth = 0;
@@ -50,29 +45,54 @@ std::vector<MapObject*> QuadTreeNode::retrieve(const sf::FloatRect& bounds, sf::
         }
     }
     // and append objects in this node
-    foundObjects.insert(foundObjects.end(), mObjects.begin(), mObjects.end());
-    mDebugShape.setOutlineColor(sf::Color::Red);
+    for(const auto& entry : mObjects)
+        foundObjects.push_back(entry.object);
+    mSearched = true;
     return foundObjects;
 }
 
+void QuadTreeNode::query(const sf::FloatRect& bounds, std::vector<MapObject*>& dest) const
+{
+    auto touches = [&bounds](const sf::FloatRect& area)
+    {
+        return bounds.left <= area.left + area.width && area.left <= bounds.left + bounds.width
+            && bounds.top <= area.top + area.height && area.top <= bounds.top + bounds.height;
+    };
+    
+    for(const auto& entry : mObjects)
+    {
+        if(touches(entry.aabb)) dest.push_back(entry.object);
+    }
+    for(const auto& child : mChildren)
+    {
+        if(touches(child->mBounds)) child->query(bounds, dest);
+    }
+}
+
 void QuadTreeNode::insert(const MapObject& object)
+{
+    insert(object, object.getAABB());
+}
+
+void QuadTreeNode::insert(const MapObject& object, const sf::FloatRect& aabb)
 {
     // check if an object falls completely outside a node
-    if(!object.getAABB().intersects(mBounds)) return;
+    if(!aabb.intersects(mBounds)) return;
     
     // if node is already split add object to corresponding child node
     // if it fits
     if(!mChildren.empty())
     {
-        sf::Int16 index = getIndex(object.getAABB());
+        sf::Int16 index = getIndex(aabb);
         if(index != -1)
         {
-            mChildren[index]->insert(object);
+            mChildren[index]->insert(object, aabb);
             return;
         }
     }
     // else add object to this node
-    mObjects.push_back(const_cast<MapObject*>(&object));
+    Entry entry = { const_cast<MapObject*>(&object), aabb };
+    mObjects.push_back(entry);
     
     // check number of objects in this node, and split if necessary
     // adding any objects that fit to the new child node.
@@ -84,10 +104,10 @@ void QuadTreeNode::insert(const MapObject& object)
         sf::Uint16 i = 0;
         while(i < mObjects.size())
         {
-            sf::Int16 index = getIndex(mObjects[i]->getAABB());
+            sf::Int16 index = getIndex(mObjects[i].aabb);
             if(index != -1)
             {
-                mChildren[index]->insert(*mObjects[i]);
+                mChildren[index]->insert(*mObjects[i].object, mObjects[i].aabb);
                 mObjects.erase(mObjects.begin() + i);
             }
             else
@@ -108,7 +128,13 @@ void QuadTreeNode::draw(sf::RenderTarget& rt, sf::RenderStates states) const
         rt.draw(*child);
     }
     
-    rt.draw(mDebugShape);
+    // only built when debug drawing so the tree doesn't hold a shape per node
+    sf::RectangleShape shape(sf::Vector2f(mBounds.width, mBounds.height));
+    shape.setPosition(mBounds.left, mBounds.top);
+    shape.setFillColor(sf::Color::Transparent);
+    shape.setOutlineColor(mSearched ? sf::Color::Red : sf::Color::Green);
+    shape.setOutlineThickness(-2.f);
+    rt.draw(shape);
 }
 
 void QuadTreeNode::split()
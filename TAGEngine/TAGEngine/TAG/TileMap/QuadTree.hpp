@@ -20,8 +20,14 @@ public:
     // appear in quads which are contained or intersect bounds.
     std::vector<MapObject*> retrieve(const sf::FloatRect& bounds, sf::Uint16& currentDepth);
     
+    // appends the objects whose AABB touches bounds to dest, without allocating a vector per node
+    // or marking nodes for debug drawing. Bounds with no width or height still find what they touch.
+    void query(const sf::FloatRect& bounds, std::vector<MapObject*>& dest) const;
+    
     // insert a reference to the object into the node's object list
     void insert(const MapObject& object);
+    // as above using an AABB already read from the object store, so the object itself isn't touched
+    void insert(const MapObject& object, const sf::FloatRect& aabb);
     
 protected:
     // maximum objects per node before splitting
@@ -31,9 +37,15 @@ protected:
     
     sf::Uint16 mLevel;
     sf::FloatRect mBounds;
-    std::vector<MapObject*> mObjects; // objects contined in current node.
+    // objects contained in current node, with a copy of their AABB when inserted
+    struct Entry
+    {
+        MapObject* object;
+        sf::FloatRect aabb;
+    };
+    std::vector<Entry> mObjects;
     std::vector<std::unique_ptr<QuadTreeNode>> mChildren; // vector of child nodes.
-    sf::RectangleShape mDebugShape;
+    bool mSearched; // drawn in red by debug drawing once a query has visited the node
     
     // Returns the index of the child node into which the given bounds fits.
     // returns -1 if it doesn't completely fit a child. Numbered anti-clockwise
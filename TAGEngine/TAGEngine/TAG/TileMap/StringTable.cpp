@@ -0,0 +1,43 @@
+#include "StringTable.hpp"
+
+#include <cassert>
+
+namespace tmx
+{
+    StringTable::StringTable()
+    {
+        intern(std::string());
+    }
+    
+    StringId StringTable::intern(const std::string& str)
+    {
+        auto result = mIds.insert(std::make_pair(str, static_cast<StringId>(mStrings.size())));
+        if(result.second) mStrings.push_back(&result.first->first);
+        return result.first->second;
+    }
+    
+    StringId StringTable::find(const std::string& str) const
+    {
+        auto result = mIds.find(str);
+        return (result == mIds.end()) ? InvalidString : result->second;
+    }
+    
+    const std::string& StringTable::get(StringId id) const
+    {
+        assert(id < mStrings.size());
+        return *mStrings[id];
+    }
+    
+    void StringTable::clear()
+    {
+        mIds.clear();
+        mStrings.clear();
+        intern(std::string());
+    }
+    
+    StringTable& defaultStringTable()
+    {
+        static StringTable strings;
+        return strings;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+// Interns the names, types and property strings of a map so each distinct string is stored once.
+// Objects and layers keep small integer handles instead of strings, which are compared without
+// touching the text, for example to filter objects by type.
+
+#include <SFML/Config.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace tmx
+{
+    typedef sf::Uint32 StringId;
+    // the handle of the empty string in every table, so unset names need no lookup
+    const StringId EmptyString = 0u;
+    // returned by StringTable::find for strings which aren't in the table
+    const StringId InvalidString = 0xffffffffu;
+    
+    class StringTable final
+    {
+    public:
+        StringTable();
+        
+        // returns the handle of str, adding it to the table if needed
+        StringId intern(const std::string& str);
+        // returns the handle of str, or InvalidString if it hasn't been interned
+        StringId find(const std::string& str) const;
+        // the string of a handle returned by this table, which stays valid until the table is cleared
+        const std::string& get(StringId id) const;
+        
+        std::size_t size() const { return mStrings.size(); }
+        // removes every string but the empty string, invalidating all other handles
+        void clear();
+        
+    private:
+        std::unordered_map<std::string, StringId> mIds;
+        std::vector<const std::string*> mStrings; // keys of mIds, which don't move as it grows
+    };
+    
+    // shared by objects and layers created without a map of their own
+    StringTable& defaultStringTable();
+}
\ No newline at end of file
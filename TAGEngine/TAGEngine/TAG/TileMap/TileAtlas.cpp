@@ -0,0 +1,117 @@
+#include "TileAtlas.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+    // a row of images along a page, as tall as the first (tallest) image placed on it
+    struct Shelf
+    {
+        unsigned int top;
+        unsigned int height;
+        unsigned int nextX;
+    };
+
+    struct Page
+    {
+        std::vector<Shelf> shelves;
+        unsigned int nextY;
+    };
+}
+
+namespace tmx
+{
+    bool packAtlas(const std::vector<sf::Vector2u>& sizes, unsigned int maxSize, unsigned int padding, AtlasLayout& layout)
+    {
+        layout.placements.assign(sizes.size(), AtlasLayout::Placement());
+        layout.pageSizes.clear();
+
+        // place the tallest images first so shelves waste as little height as possible.
+        // ties are broken by width then index so the order is always the same.
+        std::vector<sf::Uint32> order(sizes.size());
+        for(sf::Uint32 i = 0u; i < order.size(); ++i)
+        {
+            if(sizes[i].x > maxSize || sizes[i].y > maxSize) return false;
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&sizes](sf::Uint32 a, sf::Uint32 b)
+        {
+            if(sizes[a].y != sizes[b].y) return sizes[a].y > sizes[b].y;
+            if(sizes[a].x != sizes[b].x) return sizes[a].x > sizes[b].x;
+            return a < b;
+        });
+
+        std::vector<Page> pages;
+        for(const auto index : order)
+        {
+            const sf::Vector2u& size = sizes[index];
+            AtlasLayout::Placement& placement = layout.placements[index];
+            bool placed = false;
+
+            // first fit on an existing shelf, then on a new shelf of an existing page
+            for(sf::Uint32 p = 0u; p < pages.size() && !placed; ++p)
+            {
+                for(auto& shelf : pages[p].shelves)
+                {
+                    if(size.y <= shelf.height && shelf.nextX + size.x <= maxSize)
+                    {
+                        placement.page = p;
+                        placement.position = sf::Vector2u(shelf.nextX, shelf.top);
+                        shelf.nextX += size.x + padding;
+                        placed = true;
+                        break;
+                    }
+                }
+
+                if(!placed && pages[p].nextY + size.y <= maxSize)
+                {
+                    Shelf shelf = { pages[p].nextY, size.y, size.x + padding };
+                    pages[p].shelves.push_back(shelf);
+                    pages[p].nextY += size.y + padding;
+
+                    placement.page = p;
+                    placement.position = sf::Vector2u(0u, shelf.top);
+                    placed = true;
+                }
+            }
+
+            if(!placed)
+            {
+                Page page;
+                Shelf shelf = { 0u, size.y, size.x + padding };
+                page.shelves.push_back(shelf);
+                page.nextY = size.y + padding;
+                pages.push_back(page);
+
+                placement.page = pages.size() - 1u;
+                placement.position = sf::Vector2u();
+            }
+        }
+
+        // pages are only as large as the images placed on them
+        layout.pageSizes.resize(pages.size());
+        for(sf::Uint32 i = 0u; i < sizes.size(); ++i)
+        {
+            sf::Vector2u& pageSize = layout.pageSizes[layout.placements[i].page];
+            pageSize.x = std::max(pageSize.x, layout.placements[i].position.x + sizes[i].x);
+            pageSize.y = std::max(pageSize.y, layout.placements[i].position.y + sizes[i].y);
+        }
+        return true;
+    }
+
+    void createAtlasPages(const AtlasLayout& layout, const std::vector<const sf::Image*>& images, std::vector<sf::Image>& pages)
+    {
+        assert(images.size() == layout.placements.size());
+
+        pages.resize(layout.pageSizes.size());
+        for(sf::Uint32 i = 0u; i < pages.size(); ++i)
+            pages[i].create(layout.pageSizes[i].x, layout.pageSizes[i].y, sf::Color::Transparent);
+
+        for(sf::Uint32 i = 0u; i < images.size(); ++i)
+        {
+            const AtlasLayout::Placement& placement = layout.placements[i];
+            pages[placement.page].copy(*images[i], placement.position.x, placement.position.y);
+        }
+    }
+}
\ No newline at end of file
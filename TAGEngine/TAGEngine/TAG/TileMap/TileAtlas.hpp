@@ -0,0 +1,30 @@
+#pragma once
+
+// Packs tileset images into atlas pages so tiles from different tilesets can share a texture,
+// and therefore a LayerSet. Packing only depends on the image sizes given and the order they are
+// given in, so a map always produces the same atlas, and only uses sf::Image so runs without a GPU.
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <vector>
+
+namespace tmx
+{
+    struct AtlasLayout
+    {
+        struct Placement
+        {
+            sf::Uint32 page;
+            sf::Vector2u position; // top left of the image on the page
+        };
+        std::vector<Placement> placements; // one for each packed image, in the order given
+        std::vector<sf::Vector2u> pageSizes;
+    };
+
+    // packs images of the given sizes into as few pages no larger than maxSize square as it can,
+    // leaving padding pixels between images. Returns false if an image is larger than maxSize.
+    bool packAtlas(const std::vector<sf::Vector2u>& sizes, unsigned int maxSize, unsigned int padding, AtlasLayout& layout);
+    // copies images into pages according to layout. images must be in the order they were packed.
+    void createAtlasPages(const AtlasLayout& layout, const std::vector<const sf::Image*>& images, std::vector<sf::Image>& pages);
+}
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "TileLayout.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // converts after clamping, so areas far outside the map can't overflow the conversion
+    int toInt(float value)
+    {
+        return static_cast<int>(std::min(std::max(value, -1.0e9f), 1.0e9f));
+    }
+}
+
+namespace tmx
+{
+    TileLayout::TileLayout()
+     : mOrientation(Orthogonal)
+     , mTileSize(1u, 1u)
+     , mStaggerX(false)
+     , mStaggerEven(false)
+    {}
+    
+    TileLayout::TileLayout(MapOrientation orientation, const sf::Vector2u& mapSize, const sf::Vector2u& tileSize,
+                           bool staggerX, bool staggerEven)
+     : mOrientation(orientation)
+     , mMapSize(mapSize)
+     , mTileSize(tileSize)
+     , mStaggerX(staggerX)
+     , mStaggerEven(staggerEven)
+     , mGridSize(mapSize)
+    {
+        if(mOrientation == Orthogonal || mapSize.x == 0u || mapSize.y == 0u) return;
+        
+        // the isometric coordinates of the tiles are most extreme around the edges of the map
+        sf::Vector2i min = isometric(0, 0);
+        sf::Vector2i max = min;
+        auto grow = [&](int x, int y)
+        {
+            const sf::Vector2i position = isometric(x, y);
+            min.x = std::min(min.x, position.x);
+            min.y = std::min(min.y, position.y);
+            max.x = std::max(max.x, position.x);
+            max.y = std::max(max.y, position.y);
+        };
+        const int lastX = static_cast<int>(mapSize.x) - 1;
+        const int lastY = static_cast<int>(mapSize.y) - 1;
+        for(int x = 0; x <= lastX; ++x)
+        {
+            grow(x, 0);
+            grow(x, lastY);
+        }
+        for(int y = 0; y <= lastY; ++y)
+        {
+            grow(0, y);
+            grow(lastX, y);
+        }
+        mGridOffset = -min;
+        mGridSize = sf::Vector2u(max.x - min.x + 1, max.y - min.y + 1);
+        
+        // tiled places the first row or column of isometric and stepped maps at the left and top of the map
+        const float halfWidth = static_cast<float>(tileSize.x) / 2.f;
+        const float halfHeight = static_cast<float>(tileSize.y) / 2.f;
+        sf::Vector2f base;
+        if(mOrientation == Isometric)
+            base.x = static_cast<float>(lastY) * halfWidth;
+        else if(mStaggerEven && mStaggerX)
+            base.y = halfHeight;
+        else if(mStaggerEven)
+            base.x = halfWidth;
+        
+        mGridOrigin.x = base.x + static_cast<float>(mGridOffset.y - mGridOffset.x) * halfWidth;
+        mGridOrigin.y = base.y - static_cast<float>(mGridOffset.x + mGridOffset.y) * halfHeight;
+    }
+    
+    sf::Vector2i TileLayout::isometric(int x, int y) const
+    {
+        if(mOrientation != SteppedIsometric) return sf::Vector2i(x, y);
+        
+        // stepped tiles sit on every other cell of an isometric grid. Across and down are the
+        // sum and difference of the isometric coordinates, which always have the same parity.
+        const int staggered = mStaggerX ? x : y;
+        const int offset = (((staggered & 1) != 0) != mStaggerEven) ? 1 : 0;
+        const int even = mStaggerEven ? 1 : 0;
+        const int across = mStaggerX ? x : 2 * x + offset - even;
+        const int down = mStaggerX ? 2 * y + offset - even : y;
+        return sf::Vector2i((down + across) / 2, (down - across) / 2);
+    }
+    
+    sf::Vector2i TileLayout::toGrid(int x, int y) const
+    {
+        return isometric(x, y) + mGridOffset;
+    }
+    
+    bool TileLayout::fromGrid(int gridX, int gridY, int& x, int& y) const
+    {
+        if(mOrientation == SteppedIsometric)
+        {
+            const int across = (gridX - mGridOffset.x) - (gridY - mGridOffset.y);
+            const int down = (gridX - mGridOffset.x) + (gridY - mGridOffset.y);
+            const int even = mStaggerEven ? 1 : 0;
+            if(mStaggerX)
+            {
+                x = across;
+                const int offset = (((x & 1) != 0) != mStaggerEven) ? 1 : 0;
+                y = (down - offset + even) / 2;
+            }
+            else
+            {
+                y = down;
+                const int offset = (((y & 1) != 0) != mStaggerEven) ? 1 : 0;
+                x = (across - offset + even) / 2;
+            }
+        }
+        else
+        {
+            x = gridX - mGridOffset.x;
+            y = gridY - mGridOffset.y;
+        }
+        return x >= 0 && y >= 0 && x < static_cast<int>(mMapSize.x) && y < static_cast<int>(mMapSize.y);
+    }
+    
+    sf::Vector2f TileLayout::tilePosition(int x, int y) const
+    {
+        if(mOrientation == Orthogonal)
+            return sf::Vector2f(static_cast<float>(x * mTileSize.x), static_cast<float>(y * mTileSize.y));
+        
+        const sf::Vector2i grid = toGrid(x, y);
+        return sf::Vector2f(mGridOrigin.x + static_cast<float>(grid.x - grid.y) * mTileSize.x / 2.f,
+                            mGridOrigin.y + static_cast<float>(grid.x + grid.y) * mTileSize.y / 2.f);
+    }
+    
+    sf::Vector2f TileLayout::objectPosition(const sf::Vector2f& position) const
+    {
+        if(mOrientation != Isometric) return position;
+        
+        // object coordinates start at the top corner of tile 0, 0
+        const sf::Vector2f tile = position / static_cast<float>(mTileSize.y);
+        const sf::Vector2f origin = tilePosition(0, 0);
+        return sf::Vector2f(origin.x + (1.f + tile.x - tile.y) * mTileSize.x / 2.f,
+                            origin.y + (tile.x + tile.y) * mTileSize.y / 2.f);
+    }
+    
+    sf::FloatRect TileLayout::gridBounds(const sf::Vector2i& first, const sf::Vector2i& last) const
+    {
+        const sf::Vector2f tileSize(static_cast<float>(mTileSize.x), static_cast<float>(mTileSize.y));
+        if(mOrientation == Orthogonal)
+        {
+            return sf::FloatRect(first.x * tileSize.x, first.y * tileSize.y,
+                                 (last.x - first.x + 1) * tileSize.x, (last.y - first.y + 1) * tileSize.y);
+        }
+        
+        // a block of diamond cells is widest between its left and right corners, and tallest
+        // between its top and bottom corners
+        const float left = mGridOrigin.x + static_cast<float>(first.x - last.y) * tileSize.x / 2.f;
+        const float right = mGridOrigin.x + static_cast<float>(last.x - first.y) * tileSize.x / 2.f + tileSize.x;
+        const float top = mGridOrigin.y + static_cast<float>(first.x + first.y) * tileSize.y / 2.f;
+        const float bottom = mGridOrigin.y + static_cast<float>(last.x + last.y) * tileSize.y / 2.f + tileSize.y;
+        return sf::FloatRect(left, top, right - left, bottom - top);
+    }
+    
+    void TileLayout::diagonals(const sf::FloatRect& area, sf::Vector2i& across, sf::Vector2i& down) const
+    {
+        // a cell covers a tile sized box from its top left, so overlaps area when its top left is
+        // less than a tile above or left of area and not past its right or bottom
+        const float halfWidth = static_cast<float>(mTileSize.x) / 2.f;
+        const float halfHeight = static_cast<float>(mTileSize.y) / 2.f;
+        across.x = toInt(std::floor((area.left - mGridOrigin.x - mTileSize.x) / halfWidth));
+        across.y = toInt(std::ceil((area.left + area.width - mGridOrigin.x) / halfWidth));
+        down.x = toInt(std::floor((area.top - mGridOrigin.y - mTileSize.y) / halfHeight));
+        down.y = toInt(std::ceil((area.top + area.height - mGridOrigin.y) / halfHeight));
+    }
+    
+    void TileLayout::gridRows(const sf::FloatRect& area, int& first, int& last) const
+    {
+        if(mOrientation == Orthogonal)
+        {
+            first = toInt(std::floor(area.top / mTileSize.y));
+            last = toInt(std::floor((area.top + area.height) / mTileSize.y));
+            return;
+        }
+        
+        // gridY is half of down - across
+        sf::Vector2i across, down;
+        diagonals(area, across, down);
+        first = static_cast<int>(std::floor((down.x - across.y) / 2.f));
+        last = static_cast<int>(std::ceil((down.y - across.x) / 2.f));
+    }
+    
+    void TileLayout::gridColumns(const sf::FloatRect& area, int firstRow, int lastRow, int& first, int& last) const
+    {
+        if(mOrientation == Orthogonal)
+        {
+            first = toInt(std::floor(area.left / mTileSize.x));
+            last = toInt(std::floor((area.left + area.width) / mTileSize.x));
+            return;
+        }
+        
+        // gridX is both across + gridY and down - gridY, so the visible columns of a band of rows
+        // narrow to the diamond of the area rather than its bounding box
+        sf::Vector2i across, down;
+        diagonals(area, across, down);
+        first = std::max(across.x + firstRow, down.x - lastRow);
+        last = std::min(across.y + lastRow, down.y - firstRow);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+// Where the tiles of a map are placed for each map orientation. Shared by the map, which builds
+// tile vertices, and its layer sets, which group them into patches and cull them, so both agree.
+//
+// Tiles are patched on a grid which is the map itself for orthogonal maps, and the diamond grid
+// of an isometric map otherwise. Stepped (staggered) maps are an isometric grid with alternate
+// rows or columns offset, so their tiles map exactly onto isometric grid cells. Drawing the grid
+// in row order, patch by patch, then always draws tiles behind before the tiles in front of them.
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+
+namespace tmx
+{
+    enum MapOrientation
+    {
+        Orthogonal,
+        Isometric,
+        SteppedIsometric
+    };
+    
+    class TileLayout final
+    {
+    public:
+        TileLayout();
+        // staggerX and staggerEven only apply to stepped maps. staggerX offsets alternate columns down
+        // rather than alternate rows right, staggerEven offsets the even rather than odd rows or columns.
+        TileLayout(MapOrientation orientation, const sf::Vector2u& mapSize, const sf::Vector2u& tileSize,
+                   bool staggerX = false, bool staggerEven = false);
+        
+        MapOrientation getOrientation() const { return mOrientation; }
+        bool getStaggerX() const { return mStaggerX; }
+        bool getStaggerEven() const { return mStaggerEven; }
+        const sf::Vector2u& getMapSize() const { return mMapSize; }
+        const sf::Vector2u& getTileSize() const { return mTileSize; }
+        // size of the patching grid, which for stepped maps has cells outside the map
+        const sf::Vector2u& getGridSize() const { return mGridSize; }
+        
+        // the grid cell of a map tile, and the map tile of a grid cell. fromGrid returns false
+        // for grid cells outside the map.
+        sf::Vector2i toGrid(int x, int y) const;
+        bool fromGrid(int gridX, int gridY, int& x, int& y) const;
+        
+        // top left of the cell of a map tile, which for isometric maps bounds the tile's diamond
+        sf::Vector2f tilePosition(int x, int y) const;
+        // converts a position in tiled's object coordinates to world coordinates. Objects on isometric
+        // maps are measured in tile heights along both axes of the grid, on other maps they're in pixels.
+        sf::Vector2f objectPosition(const sf::Vector2f& position) const;
+        // bounds of the cells of grid cells first to last inclusive
+        sf::FloatRect gridBounds(const sf::Vector2i& first, const sf::Vector2i& last) const;
+        
+        // the grid rows with cells which may overlap area, then the grid columns in rows firstRow
+        // to lastRow which may. Ranges are conservative and aren't clamped to the grid.
+        void gridRows(const sf::FloatRect& area, int& first, int& last) const;
+        void gridColumns(const sf::FloatRect& area, int firstRow, int lastRow, int& first, int& last) const;
+        
+    private:
+        MapOrientation mOrientation;
+        sf::Vector2u mMapSize;
+        sf::Vector2u mTileSize;
+        bool mStaggerX;
+        bool mStaggerEven;
+        
+        sf::Vector2u mGridSize;
+        sf::Vector2i mGridOffset; // added to isometric coordinates so grid cells start at 0
+        sf::Vector2f mGridOrigin; // top left of the cell of grid cell 0, 0
+        
+        // isometric coordinates of a map tile, before the grid offset
+        sf::Vector2i isometric(int x, int y) const;
+        // the ranges of gridX - gridY and gridX + gridY of diamond grid cells which may overlap area
+        void diagonals(const sf::FloatRect& area, sf::Vector2i& across, sf::Vector2i& down) const;
+    };
+}
\ No newline at end of file
@@ -4,30 +4,76 @@
 #include "ResourcePath.hpp"
 
 #include "SceneNode.hpp"
+#include "MapCache.hpp"
+#include "MappedFile.hpp"
+#include "ChunkStreamer.hpp"
+#include "TileAtlas.hpp"
+#include "DebugDraw.hpp"
+#include "Random.hpp"
 //#include "Square.hpp"
 
 #include <algorithm>
 #include <sstream>
 #include <cstring>
 #include <zlib.h>
+#ifdef TAG_USE_ZSTD
+#include <zstd.h>
+#endif
 #include <utility>
 #include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <SFML/System/Lock.hpp>
+#include <SFML/System/Clock.hpp>
 
 int Logger::mLogFilter = (Type::Error | Type::Info | Type::Warning);
 
+namespace
+{
+    // identifies map cache files, "TAGM" in little endian
+    const sf::Uint32 CacheMagic = 0x4d474154;
+    // pixels left between tilesets packed into an atlas, so filtering doesn't bleed between them
+    const unsigned int AtlasPadding = 2u;
+    // the horizontal, vertical and diagonal flip flags stored in the top bits of a gid
+    const sf::Uint32 FlipFlags = 0xe0000000;
+    
+    // decodes base64 encoded strings into a byte buffer, skipping any whitespace.
+    // returns false if the string contains characters outside the base64 alphabet
+    bool base64Decode(const char* encoded, std::vector<unsigned char>& dest);
+    // decodes into a buffer of destSize bytes, returns the number of bytes written or -1 on failure
+    long base64Decode(const char* encoded, unsigned char* dest, std::size_t destSize);
+    // parses comma separated gids in place into a buffer of destCount ids, returns the number of ids read or -1 on failure
+    long parseCsv(const char* text, sf::Uint32* dest, std::size_t destCount);
+    // converts gids read from little endian layer data to host byte order
+    void gidsFromLittleEndian(std::vector<sf::Uint32>& gids);
+    // true if every gid, without its flip flags, indexes one of tileCount tiles
+    bool gidsInRange(const std::vector<sf::Uint32>& gids, std::size_t tileCount);
+}
+
 TileMap::TileMap(sf::Uint8 patchSize)
  : mTileWidth(1u)
  , mTileHeight(1u)
  , mCols(1u)
  , mRows(1u)
- , mPatchSize(patchSize)
  , mLayers()
- , mTilesetTextures()
  , mProperties()
+ , mTilesetTextures()
+ , mPatchSize(patchSize)
+ , mAtlasEnabled(false)
  , mTileInfo()
+ , mCollisionLayerIndex(-1)
+ , mCollisionObjects(false)
+ , mQuadTreeAvailable(false)
  , mCachedImages()
  , mFailedImage(false)
- , mQuadTreeAvailable(false)
+ , mCacheEnabled(true)
+ , mStreaming(false)
+ , mStreamBudget(0u)
+ , mStreamLookAhead(0.f)
+ , mResidentMemory(0u)
+ , mStreamFrame(0u)
+ , mMergePatches(false)
 {
     // reserve some space
     mLayers.reserve(5);
@@ -40,6 +86,13 @@ TileMap::~TileMap()
     unLoad();
 }
 
+void TileMap::update(sf::Time dt)
+{
+    updateAnimations(dt);
+    for(auto& layer : mLayers)
+        layer.update();
+}
+
 void TileMap::draw(sf::RenderTarget& rt, MapLayer::DrawType type, bool debug)
 {
     setDrawingBounds(rt.getView());
@@ -64,18 +117,11 @@ void TileMap::draw(sf::RenderTarget& rt, MapLayer::DrawType type, bool debug)
                 drawLayer(rt, layer, debug);
             }
         case MapLayer::Debug :
-            for(auto layer : mLayers)
+            for(sf::Uint16 i = 0u; i < mLayers.size(); ++i)
             {
-                if(layer.type == tmx::ObjectGroup)
-                {
-                    for(const auto& object : layer.objects)
-                    {
-                        if(mBounds.intersects(object.getAABB()))
-                            object.drawDebugShape(rt);
-                    }
-                }
+                if(mLayers[i].type == tmx::ObjectGroup) drawDebugObjects(rt, i);
             }
-            rt.draw(mGridVertices);
+            getDebugDraw().drawGrid(rt, mLayout);
             rt.draw(mRootNode);
             break;
     }
@@ -92,40 +138,32 @@ void TileMap::drawLayer(sf::RenderTarget& rt, MapLayer& layer, bool debug)
     rt.draw(layer);
     
     if(debug && layer.type == tmx::ObjectGroup)
-    {
-        for(const auto& object : layer.objects)
-            if(mBounds.intersects(object.getAABB()))
-            {
-                object.drawDebugShape(rt);
-            }
-    }
+        drawDebugObjects(rt, static_cast<sf::Uint16>(&layer - mLayers.data()));
 }
 
-void TileMap::draw(sf::RenderTarget& rt, sf::RenderStates states) const
+void TileMap::drawDebugObjects(sf::RenderTarget& rt, sf::Uint16 layer)
 {
-    sf::View view  = rt.getView();
+    // cull with the packed AABBs and only touch the objects which are drawn
+    const auto range = mObjectStore.getLayerRange(layer);
+    if(range.second == 0u) return;
     
-    if(view.getCenter() != mLastViewPos)
-    {
-        sf::FloatRect bounds;
-        bounds.left = view.getCenter().x - (view.getSize().x / 2.f);
-        bounds.top = view.getCenter().y - (view.getSize().y / 2.f);
-        bounds.width = view.getSize().x;
-        bounds.height = view.getSize().y;
-        
-        //add a tile border to prevent gaps appearing
-        bounds.left -= static_cast<float>(mTileWidth);
-        bounds.top -= static_cast<float>(mTileHeight);
-        bounds.width += static_cast<float>(mTileWidth * 2);
-        bounds.height += static_cast<float>(mTileHeight * 2);
-        mBounds = bounds;
-        
-        for(auto& layer : mLayers)
-            layer.cull(mBounds);
-    }
-    mLastViewPos = view.getCenter();
+    mObjectIds.clear();
+    mObjectStore.query(mBounds, mObjectIds, range.first, range.second);
+    for(const auto id : mObjectIds)
+        getDebugDraw().drawObject(rt, mObjectStore.getObject(id));
+}
 
-	for(auto& layer : mLayers)
+tmx::DebugDraw& TileMap::getDebugDraw()
+{
+    if(!mDebugDraw) mDebugDraw = std::unique_ptr<tmx::DebugDraw>(new tmx::DebugDraw());
+    return *mDebugDraw;
+}
+
+void TileMap::draw(sf::RenderTarget& rt, sf::RenderStates states) const
+{
+    // culling and merging patches modify the layers, so they're done by setDrawingBounds
+    // and update rather than here
+	for(const auto& layer : mLayers)
 		rt.draw(layer);
 }
 
@@ -154,13 +192,11 @@ void TileMap::setDrawingBounds(const sf::View& view)
 
 void TileMap::updateQuadTree(const sf::FloatRect& rootArea)
 {
+    // insert from the packed AABBs so objects outside the root area are never touched
     mRootNode.clear(rootArea);
-    for(const auto& layer : mLayers)
+    for(sf::Uint32 id = 0u; id < mObjectStore.size(); ++id)
     {
-        for(const auto& object : layer.objects)
-        {
-            mRootNode.insert(object);
-        }
+        mRootNode.insert(mObjectStore.getObject(id), mObjectStore.getAABB(id));
     }
     mQuadTreeAvailable = true;
 }
@@ -172,8 +208,78 @@ std::vector<MapObject*> TileMap::QueryQuadTree(const sf::FloatRect& testArea)
     return mRootNode.retrieve(testArea);
 }
     
+const tmx::StringTable& TileMap::getStrings() const
+{
+    return mStrings;
+}
+
+const tmx::ObjectStore& TileMap::getObjectStore() const
+{
+    return mObjectStore;
+}
+
 bool TileMap::quadTreeAvailable() const
 {
+    return mQuadTreeAvailable;
+}
+
+bool TileMap::sweepObjects(const sf::FloatRect& box, const sf::Vector2f& displacement, ObjectHit& hit)
+{
+    return sweepObject(box, displacement, hit);
+}
+
+bool TileMap::raycastObjects(const sf::Vector2f& start, const sf::Vector2f& end, ObjectHit& hit)
+{
+    return sweepObject(sf::FloatRect(start, sf::Vector2f()), end - start, hit);
+}
+
+std::size_t TileMap::sweepObjects(const std::vector<ObjectSweep>& sweeps, std::vector<ObjectHit>& hits)
+{
+    hits.resize(sweeps.size());
+    std::size_t count = 0u;
+    for(std::size_t i = 0u; i < sweeps.size(); ++i)
+    {
+        if(sweepObject(sweeps[i].box, sweeps[i].displacement, hits[i])) count++;
+    }
+    return count;
+}
+
+bool TileMap::sweepObject(const sf::FloatRect& box, const sf::Vector2f& displacement, ObjectHit& hit)
+{
+    hit.object = nullptr;
+    hit.normal = sf::Vector2f();
+    hit.time = 1.f;
+    
+    // the area the box passes over, only objects touching it can be hit
+    const sf::FloatRect area(std::min(box.left, box.left + displacement.x), std::min(box.top, box.top + displacement.y),
+                             box.width + std::abs(displacement.x), box.height + std::abs(displacement.y));
+    
+    // both queries test AABBs inclusively, as the area of a straight ray has no width or height
+    mSweepCandidates.clear();
+    if(mQuadTreeAvailable)
+    {
+        mRootNode.query(area, mSweepCandidates);
+    }
+    else
+    {
+        mObjectIds.clear();
+        mObjectStore.query(area, mObjectIds);
+        for(const auto id : mObjectIds)
+            mSweepCandidates.push_back(&mObjectStore.getObject(id));
+    }
+    
+    for(const auto object : mSweepCandidates)
+    {
+        float time;
+        sf::Vector2f normal;
+        if(object->sweep(box, displacement, time, normal) && (!hit.object || time < hit.time))
+        {
+            hit.object = object;
+            hit.normal = normal;
+            hit.time = time;
+        }
+    }
+    return hit.object != nullptr;
 }
     
 unsigned int TileMap::getTileWidth() const
@@ -206,6 +312,11 @@ unsigned int TileMap::getMapHeight() const
     return mRows * mTileWidth;
 }
 
+const tmx::TileLayout& TileMap::getLayout() const
+{
+    return mLayout;
+}
+
 std::vector<MapLayer>& TileMap::getLayers()
 {
     return mLayers;
@@ -227,12 +338,96 @@ void TileMap::setLayerShader(sf::Uint16 layerId, const sf::Shader& shader)
     mLayers[layerId].setShader(shader);
 }
 
+DrawStats TileMap::getDrawStats() const
+{
+    DrawStats stats;
+    for(const auto& layer : mLayers)
+        layer.countDrawn(stats);
+    return stats;
+}
+
+void TileMap::setMergePatches(bool merge)
+{
+    mMergePatches = merge;
+    for(auto& layer : mLayers)
+    {
+        for(auto& set : layer.layerSets)
+            set.second->setMergePatches(merge);
+    }
+}
+
+void TileMap::setAtlasEnabled(bool enabled)
+{
+    mAtlasEnabled = enabled;
+}
+
+void TileMap::setCollisionLayer(const std::string& layerName)
+{
+    mCollisionLayer = layerName;
+    mCollisionProperty.clear();
+}
+
+void TileMap::setCollisionProperty(const std::string& propertyName)
+{
+    mCollisionProperty = propertyName;
+    mCollisionLayer.clear();
+}
+
+const CollisionGrid& TileMap::getCollisionGrid() const
+{
+    return mCollisionGrid;
+}
+
+void TileMap::setCollisionObjects(bool enabled)
+{
+    mCollisionObjects = enabled;
+}
+
+std::string TileMap::getTilePropertyString(sf::Uint32 gid, const std::string& name) const
+{
+    auto tile = mTileProperties.find(gid & ~FlipFlags);
+    if(tile == mTileProperties.end()) return std::string();
+    
+    auto property = tile->second.find(name);
+    return (property != tile->second.end()) ? property->second : std::string();
+}
+
+void TileMap::setCacheEnabled(bool enabled)
+{
+    mCacheEnabled = enabled;
+}
+
+void TileMap::setStreaming(bool enabled, std::size_t memoryBudget, float lookAhead)
+{
+    mStreaming = enabled;
+    mStreamBudget = memoryBudget;
+    mStreamLookAhead = lookAhead;
+}
+
 void TileMap::unLoad()
 { 
+    // the loader thread reads the layers so must be stopped before they're destroyed
+    stopStreaming();
     mTilesetTextures.clear();
+    mImageLayerTextures.clear();
+    mTilesetImages.clear();
+    mImageLayerImages.clear();
+    mAtlasLayout = tmx::AtlasLayout();
+    mLayout = tmx::TileLayout();
     mTileInfo.clear();
+    mTileProperties.clear();
+    mCollisionGrid.clear();
+    mSolidGids.clear();
+    mCollisionLayerIndex = -1;
+    mObjectStore.clear();
     mLayers.clear();
+    mStrings.clear();
+    mQuadTreeAvailable = false; // the quad tree points at objects of the cleared layers
     mProperties.clear();
+    mDependencies.clear();
+    mDebugDraw.reset();
+    mAnimations.clear();
+    mAnimationTime = sf::Time::Zero;
     mFailedImage = false;
 }
 
@@ -240,16 +435,72 @@ bool TileMap::loadMap(const std::string& filename)
 {
     // Clear any old data first
     unLoad();
+    
+    // try the prebaked cache before falling back to parsing the xml
+    const std::string cachePath = filename + ".cache";
+    bool cached = false;
+    if(mCacheEnabled)
+    {
+        cached = loadCache(cachePath);
+        if(cached)
+            LOG_INF("Loaded <" + filename + "> from cache.");
+        else // discard anything partially restored from a stale cache
+            unLoad();
+    }
+    
+    if(!cached)
+    {
+        if(!parseMapFile(filename)) return false;
+        
+        // bake in tile object offsets applied while parsing, so they're included in the cache
+        update(sf::Time::Zero);
+        
+        if(mCacheEnabled) writeCache(cachePath);
+        
+        LOG_INF("Parsed " + std::to_string(mLayers.size()) + " layers.");
+        LOG_INF("Loaded <" + filename + "> successfully.");
+    }
+    
+    if(!buildCollisionGrid())
+    {
+        unLoad();
+        return false;
+    }
+    mObjectStore.build(mLayers);
+    if(mStreaming) startStreaming();
+    
+    return true;
+}
 
-    // parse map xml, return on error.
-    pugi::xml_document mapDoc;
-    pugi::xml_parse_result result = mapDoc.load_file(filename.c_str());
+bool TileMap::loadDocument(const std::string& path, MappedFile& file, pugi::xml_document& doc)
+{
+    // map the file copy on write so pugixml can parse it in place without its own copy of the text.
+    // pages are only duplicated where the parser writes terminators or unescapes text.
+    if(!file.open(path, MappedFile::CopyOnWrite))
+    {
+        LOG_ERR("Failed to open <" + path + ">");
+        return false;
+    }
+    
+    pugi::xml_parse_result result = doc.load_buffer_inplace(file.mutableData(), file.size());
     if(!result)
     {
-        LOG_ERR("Failed to open <" + filename);
+        LOG_ERR("Failed to parse <" + path + ">");
         LOG_ERR("Reason: " + std::string(result.description()));
         return false;
     }
+    return true;
+}
+
+bool TileMap::parseMapFile(const std::string& filename)
+{
+    mDependencies.push_back(filename);
+    
+    // parse map xml, return on error. The document and the mapping it points into
+    // are only kept alive until this function returns.
+    MappedFile mapFile;
+    pugi::xml_document mapDoc;
+    if(!loadDocument(filename, mapFile, mapDoc)) return false;
     
     // Set map properties
     pugi::xml_node mapNode = mapDoc.child("map");
@@ -294,11 +545,6 @@ bool TileMap::loadMap(const std::string& filename)
         currentNode = currentNode.next_sibling();
     }
     
-    createDebugGrid();
-    
-    LOG_INF("Parsed " + std::to_string(mLayers.size()) + " layers.");
-    LOG_INF("Loaded <" + filename + "> successfully.");
-    
     return true;
 }
 
@@ -314,12 +560,26 @@ bool TileMap::parseMapNode(const pugi::xml_node& mapNode)
     }
 	
 	std::string orientation = mapNode.attribute("orientation").as_string();
-	if(orientation != "orthogonal")
+    tmx::MapOrientation mapOrientation = tmx::Orthogonal;
+    if(orientation == "isometric")
+    {
+        mapOrientation = tmx::Isometric;
+    }
+    else if(orientation == "staggered")
+    {
+        mapOrientation = tmx::SteppedIsometric;
+    }
+	else if(orientation != "orthogonal")
     {
         LOG_ERR("Map orientation " + orientation + " not currently supported. Map not loaded.");
         return false;
     }
     
+    // stepped maps offset alternate rows unless the stagger axis is x, odd ones unless the index is even
+    const bool staggerX = std::string(mapNode.attribute("staggeraxis").as_string()) == "x";
+    const bool staggerEven = std::string(mapNode.attribute("staggerindex").as_string()) == "even";
+    mLayout = tmx::TileLayout(mapOrientation, sf::Vector2u(mCols, mRows), sf::Vector2u(mTileWidth, mTileHeight), staggerX, staggerEven);
+    
     // parse any map properties
     if(pugi::xml_node propertiesNode = mapNode.child("properties"))
     {
@@ -360,18 +620,18 @@ bool TileMap::parseTilesets(const pugi::xml_node& mapNode)
             std::string file = fileFromPath(tileset.attribute("source").as_string());
             std::string path = resourcePath() + file;
             
+            // the tsx document only lives for this iteration of the loop
+            MappedFile tsxFile;
             pugi::xml_document tsxDoc;
-            pugi::xml_parse_result result;
-            
-            result = tsxDoc.load_file(path.c_str());
-            if(!result)
+            if(!loadDocument(path, tsxFile, tsxDoc))
             {
                 LOG_ERR("Failed to open external tsx doucment: " + path);
-                LOG_ERR("Reason: " + std::string(result.description()));
                 unLoad();
                 return false;
             }
             
+            mDependencies.push_back(path);
+            
             // try parsing tileset node
             pugi::xml_node ts = tsxDoc.child("tileset");
             
@@ -386,6 +646,7 @@ bool TileMap::parseTilesets(const pugi::xml_node& mapNode)
         tileset = tileset.next_sibling("tileset");
     }
     
+    if(mAtlasEnabled) return buildAtlas();
     return true;
 }
  
@@ -415,21 +676,26 @@ bool TileMap::processTiles(const pugi::xml_node& tilesetNode)
     
     // process image from disk
     std::string imageName = fileFromPath(imageNode.attribute("source").as_string());
-    sf::Image sourceImage = loadImage(resourcePath() + imageName);
-    if(mFailedImage)
+    ImageSource source;
+    source.path = resourcePath() + imageName;
+    
+    // add transparency mask from colour if it exists
+    if(imageNode.attribute("trans"))
+    {
+        source.masked = true;
+        source.mask = colorFromHex(imageNode.attribute("trans").as_string());
+    }
+    
+    // store image as a texture for drawing with vertex array. When packing an atlas the
+    // textures are created once every tileset has been loaded.
+    const sf::Vector2u imageSize = loadImage(source.path).getSize();
+    if(mFailedImage || (!mAtlasEnabled && !loadTexture(source, mTilesetTextures)))
     {
         LOG_ERR("Failed to load image " + imageName);
         return false;
     }
-    
-    // add transparency mask from colour if it exists
-    if(imageNode.attribute("trans"))
-        sourceImage.createMaskFromColor(colorFromHex(imageNode.attribute("trans").as_string()));
-        
-    // store image as a texture for drawing with vertex array
-    std::unique_ptr<sf::Texture> tileset(new sf::Texture);
-    tileset->loadFromImage(sourceImage);
-    mTilesetTextures.push_back(std::move(tileset));
+    mTilesetImages.push_back(source);
+    mDependencies.push_back(source.path);
 
     // parse offset node if it exists - TODO store somewhere tileset info can be referenced
     sf::Vector2u offset;
@@ -438,11 +704,11 @@ bool TileMap::processTiles(const pugi::xml_node& tilesetNode)
         offset.x = (offsetNode.attribute("x")) ? offsetNode.attribute("x").as_uint() : 0u;
         offset.y = (offsetNode.attribute("y")) ? offsetNode.attribute("y").as_uint() : 0u;
     }
-    // TODO parse any tile properties and store with offset above
-    
-    // slice into tiles
-    int columns = (sourceImage.getSize().x - 2u * margin + spacing) / (tileWidth + spacing);
-    int rows = (sourceImage.getSize().y - 2u * margin + spacing) / (tileHeight + spacing);
+
+    // slice into tiles. gids are assigned in order so this tileset's first gid is the next free one.
+    const sf::Uint32 firstGid = mTileInfo.size();
+    int columns = (imageSize.x - 2u * margin + spacing) / (tileWidth + spacing);
+    int rows = (imageSize.y - 2u * margin + spacing) / (tileHeight + spacing);
     
     for(int y = 0; y < rows; y++)
     {
@@ -457,19 +723,195 @@ bool TileMap::processTiles(const pugi::xml_node& tilesetNode)
             // store texture coords and tileset index for vertex array
             mTileInfo.push_back(TileInfo(rect,
                 sf::Vector2f(static_cast<float>(rect.width), static_cast<float>(rect.height)),
-                mTilesetTextures.size() - 1u));
+                mTilesetImages.size() - 1u));
         }
     }
     
+    parseAnimations(tilesetNode, firstGid);
+    parseTileProperties(tilesetNode, firstGid);
+    
     LOG_INF("Processed " + imageName);
     return true;
 }
 
+void TileMap::parseAnimations(const pugi::xml_node& tilesetNode, sf::Uint32 firstGid)
+{
+    pugi::xml_node tileNode = tilesetNode.child("tile");
+    while(tileNode)
+    {
+        if(pugi::xml_node animationNode = tileNode.child("animation"))
+        {
+            // frames refer to tiles in the same tileset by local id
+            TileAnimation animation;
+            pugi::xml_node frameNode = animationNode.child("frame");
+            while(frameNode)
+            {
+                AnimationFrame frame;
+                frame.gid = firstGid + frameNode.attribute("tileid").as_uint();
+                frame.duration = frameNode.attribute("duration").as_uint();
+                if(frame.gid < mTileInfo.size())
+                {
+                    animation.frames.push_back(frame);
+                    animation.totalDuration += frame.duration;
+                }
+                else
+                {
+                    LOG_WRN("Animation frame refers to a tile outside its tileset, skipping...");
+                }
+                frameNode = frameNode.next_sibling("frame");
+            }
+            
+            if(animation.totalDuration > 0u)
+                mAnimations[firstGid + tileNode.attribute("id").as_uint()] = animation;
+        }
+        tileNode = tileNode.next_sibling("tile");
+    }
+}
+
+void TileMap::parseTileProperties(const pugi::xml_node& tilesetNode, sf::Uint32 firstGid)
+{
+    pugi::xml_node tileNode = tilesetNode.child("tile");
+    while(tileNode)
+    {
+        if(pugi::xml_node propertiesNode = tileNode.child("properties"))
+        {
+            auto& properties = mTileProperties[firstGid + tileNode.attribute("id").as_uint()];
+            pugi::xml_node propertyNode = propertiesNode.child("property");
+            while(propertyNode)
+            {
+                properties[propertyNode.attribute("name").as_string()] = propertyNode.attribute("value").as_string();
+                propertyNode = propertyNode.next_sibling("property");
+            }
+        }
+        tileNode = tileNode.next_sibling("tile");
+    }
+}
+
+bool TileMap::buildCollisionGrid()
+{
+    if(mCollisionLayer.empty() && mCollisionProperty.empty()) return true;
+    
+    // the grid's world queries assume square tiles laid out in rows
+    if(mLayout.getOrientation() != tmx::Orthogonal)
+    {
+        LOG_ERR("Collision grids are only supported by orthogonal maps. Map not loaded.");
+        return false;
+    }
+    
+    if(!mCollisionLayer.empty())
+    {
+        for(std::size_t i = 0u; i < mLayers.size() && mCollisionLayerIndex < 0; ++i)
+        {
+            if(mLayers[i].type == tmx::Layer && mLayers[i].name == mCollisionLayer && !mLayers[i].gids.empty())
+                mCollisionLayerIndex = static_cast<sf::Int32>(i);
+        }
+        if(mCollisionLayerIndex < 0)
+        {
+            LOG_WRN("Collision layer " + mCollisionLayer + " not found, no collision grid created.");
+            return true;
+        }
+    }
+    else
+    {
+        // look up the property once per gid rather than once per tile
+        mSolidGids.assign(mTileInfo.size(), 0u);
+        for(const auto& tile : mTileProperties)
+        {
+            auto property = tile.second.find(mCollisionProperty);
+            if(tile.first < mSolidGids.size() && property != tile.second.end()
+            && property->second != "false" && property->second != "0")
+                mSolidGids[tile.first] = 1u;
+        }
+    }
+    
+    mCollisionGrid.create(mCols, mRows, sf::Vector2f(static_cast<float>(mTileWidth), static_cast<float>(mTileHeight)));
+    for(unsigned int y = 0u; y < mRows; ++y)
+    {
+        for(unsigned int x = 0u; x < mCols; ++x)
+        {
+            if(isCollisionTile(y * mCols + x))
+                mCollisionGrid.setSolid(x, y, true);
+        }
+    }
+    
+    if(mCollisionObjects) createCollisionObjects();
+    return true;
+}
+
+void TileMap::createCollisionObjects()
+{
+    std::vector<sf::IntRect> rectangles;
+    mCollisionGrid.mergeSolidTiles(rectangles);
+    
+    MapLayer layer(tmx::ObjectGroup, &mStrings);
+    layer.name = "Tile Collision";
+    layer.objects.reserve(rectangles.size());
+    for(const auto& rect : rectangles)
+    {
+        MapObject object(&mStrings);
+        object.setPosition(static_cast<float>(rect.left * mTileWidth), static_cast<float>(rect.top * mTileHeight));
+        
+        const sf::Vector2f size(static_cast<float>(rect.width * mTileWidth), static_cast<float>(rect.height * mTileHeight));
+        object.addPoint(sf::Vector2f());
+        object.addPoint(sf::Vector2f(size.x, 0.f));
+        object.addPoint(sf::Vector2f(size.x, size.y));
+        object.addPoint(sf::Vector2f(0.f, size.y));
+        object.setSize(size);
+        
+        object.setParent(layer.name);
+        object.createShape(sf::Color(127u, 127u, 127u));
+        object.createSegments();
+        layer.objects.push_back(object);
+    }
+    
+    mLayers.push_back(layer);
+    LOG_INF("Merged solid tiles into " + std::to_string(rectangles.size()) + " collision objects.");
+}
+
+bool TileMap::isCollisionTile(std::size_t cell) const
+{
+    if(mCollisionLayerIndex >= 0) return mLayers[mCollisionLayerIndex].gids[cell] != 0u;
+    
+    for(const auto& layer : mLayers)
+    {
+        if(layer.type == tmx::Layer && !layer.gids.empty() && mSolidGids[layer.gids[cell] & ~FlipFlags])
+            return true;
+    }
+    return false;
+}
+
+void TileMap::updateAnimations(sf::Time dt)
+{
+    mAnimationTime += dt;
+    const sf::Uint64 time = static_cast<sf::Uint64>(mAnimationTime.asMilliseconds());
+    
+    for(auto& a : mAnimations)
+    {
+        TileAnimation& animation = a.second;
+        
+        sf::Uint32 elapsed = static_cast<sf::Uint32>(time % animation.totalDuration);
+        sf::Uint32 frame = 0u;
+        while(elapsed >= animation.frames[frame].duration)
+        {
+            elapsed -= animation.frames[frame].duration;
+            ++frame;
+        }
+        
+        if(frame == animation.currentFrame) continue;
+        animation.currentFrame = frame;
+        
+        // frames are from the same tileset as the animated tile so only the texture coords change
+        const sf::Uint32 frameGid = animation.frames[frame].gid;
+        for(const auto& tile : animation.tiles)
+            tile.quad->setTextureCoords(tileTexCoords(frameGid | (tile.gid & FlipFlags)));
+    }
+}
+
 bool TileMap::parseLayer(const pugi::xml_node& layerNode)
 {	
     LOG_INF("Found standard map layer " + std::string(layerNode.attribute("name").as_string()));
     
-    MapLayer layer(tmx::Layer);
+    MapLayer layer(tmx::Layer, &mStrings);
     if(layerNode.attribute("name")) layer.name = layerNode.attribute("name").as_string();
     if(layerNode.attribute("opacity")) layer.opacity = layerNode.attribute("opacity").as_float();
     if(layerNode.attribute("visible")) layer.visible = layerNode.attribute("visible").as_bool();
@@ -481,26 +923,20 @@ bool TileMap::parseLayer(const pugi::xml_node& layerNode)
         return false;
     }
     
+    // the layer holds exactly one 32 bit gid per tile, so each encoding writes
+    // straight into a buffer of the final size.
+    std::vector<sf::Uint32> tileGIDs(mCols * mRows);
+    
     // Decode and decomplress data first if necessary. See https://github.com/bjorn/tiled/wiki/TMX-Map-Format#data
 	//for explanation of bytestream retrieved when using compression
     if(dataNode.attribute("encoding"))
     {
         std::string encoding = dataNode.attribute("encoding").as_string();
-        std::string data = dataNode.text().as_string();
         
         if(encoding == "base64")
         {
             LOG_INF("Found Base64 encoded layer data, decoding ...");
-            // remove any newlines or white space create by tab spaces in document.
-            std::stringstream ss;
-            ss << data;
-            ss >> data;
-            data = base64Decode(data);
-            
-            // clac the expected size of the uncompressed string
-            int expectedSize = mCols * mRows * 4; // number of tiles * 4 bytes = 32 bits/tile
-            std::vector<unsigned char> byteArray; // to hold decompressed data as bytes;
-            byteArray.reserve(expectedSize);
+            const std::size_t expectedSize = tileGIDs.size() * sizeof(sf::Uint32);
             
             // check for compression (only used with base64 encoded data)
             if(dataNode.attribute("compression"))
@@ -508,67 +944,41 @@ bool TileMap::parseLayer(const pugi::xml_node& layerNode)
                 std::string compression = dataNode.attribute("compression").as_string();
                 LOG_INF("Found " + compression + " compressed layer data, decompressing...");
                 
-                // decompress with zlib
-                int dataSize = data.length() * sizeof(unsigned char);
-                if(!decompress(data.c_str(), byteArray, dataSize, expectedSize))
+                std::vector<unsigned char> decoded;
+                if(!base64Decode(dataNode.text().get(), decoded))
+                {
+                    LOG_ERR("Invalid Base64 layer data found. Map not loaded.");
+                    return false;
+                }
+                
+                if(!decompress(decoded.data(), decoded.size(), tileGIDs, compression))
                 {
                     LOG_ERR("Failed to decompress map data. Map not loaded.");
                     return false;
                 }
             }
-            else // uncompressed 
-            {            
-                byteArray.insert(byteArray.end(), data.begin(), data.end());    
-            }
-            
-            //extract tile GIDs using bitshift (See https://github.com/bjorn/tiled/wiki/TMX-Map-Format#data) and add the tiles to layer
-            sf::Uint16 x, y;
-            x = y = 0;
-            for(int i = 0; i < expectedSize - 3; i += 4)
+            else // uncompressed, decode directly into the gid buffer
             {
-                sf::Uint32 tileGID = byteArray[i] | byteArray[i + 1] << 8 || byteArray[i + 2] << 16 | byteArray[i + 3] << 24;
-                // resolve rotation
-			    addTileToLayer(layer, x, y, tileGID);
-                
-                x++;
-                if(x == mCols)
+                long size = base64Decode(dataNode.text().get(), reinterpret_cast<unsigned char*>(tileGIDs.data()), expectedSize);
+                if(size != static_cast<long>(expectedSize))
                 {
-                    x = 0;
-                    y++;
+                    LOG_ERR("Invalid Base64 layer data found, or data does not match map size. Map not loaded.");
+                    return false;
                 }
             }
+            
+            // gids are stored little endian (See https://github.com/bjorn/tiled/wiki/TMX-Map-Format#data)
+            gidsFromLittleEndian(tileGIDs);
         }
         else if(encoding == "csv")
         {
             LOG_INF("CSV encoded layer data found.");
             
-            std::vector<sf::Uint32> tileGIDs;
-            std::stringstream datastream(data);
-            
-            // parse csv string into vector of IDs
-            sf::Uint32 i;
-            while(datastream >> i)
+            // parse csv in place from the document text
+            if(parseCsv(dataNode.text().get(), tileGIDs.data(), tileGIDs.size()) != static_cast<long>(tileGIDs.size()))
             {
-                tileGIDs.push_back(i);
-                if(datastream.peek() == ',')
-                    datastream.ignore();
-            }
-            
-            // create tiles from IDs
-            sf::Uint16 x, y;
-            x = y = 0;
-            unsigned int len = tileGIDs.size();
-            for(int i = 0; i < len; i++)
-            {
-                // resolve rotation
-			    addTileToLayer(layer, x, y, tileGIDs[i]);
-                
-                x++;
-                if(x == mCols)
-                {
-                    x = 0;
-                    y++;
-                }
+                LOG_ERR("Invalid CSV layer data found, or data does not match map size. Map not loaded.");
+                return false;
             }
         }
         else
@@ -587,32 +997,57 @@ bool TileMap::parseLayer(const pugi::xml_node& layerNode)
             return false;
         }
         
-        sf::Uint16 x, y;
-        x = y = 0;
-        while(tileNode)
+        // like the encoded data there must be exactly one tile per map cell
+        for(auto& gid : tileGIDs)
         {
-            sf::Uint32 gid = tileNode.attribute("gid").as_uint();
-            // resolve rotation
-            
-			addTileToLayer(layer, x, y, gid);
-            
+            if(!tileNode)
+            {
+                LOG_ERR("Unencoded layer data does not match map size. Map not loaded.");
+                return false;
+            }
+            gid = tileNode.attribute("gid").as_uint();
             tileNode = tileNode.next_sibling("tile");
-            x++;
-            if(x == mCols)
+        }
+        if(tileNode)
+        {
+            LOG_ERR("Unencoded layer data does not match map size. Map not loaded.");
+            return false;
+        }
+    }
+    
+    // the tile info, collision and animation lookups are indexed by gid, so gids of tiles
+    // missing from the tilesets are rejected here rather than checked at every lookup
+    if(!gidsInRange(tileGIDs, mTileInfo.size()))
+    {
+        LOG_ERR("Layer data references tiles not found in any tileset. Map not loaded.");
+        return false;
+    }
+    
+    // create tiles from IDs, empty tiles (gid 0) have nothing to draw. Tiles are added in the
+    // row order of the patch grid, which is back to front, so each patch is appended to in draw order.
+    // when streaming the vertices are built a chunk at a time as they come into view.
+    if(!mStreaming)
+    {
+        const sf::Vector2u& gridSize = mLayout.getGridSize();
+        for(int gridY = 0; gridY < static_cast<int>(gridSize.y); ++gridY)
+        {
+            for(int gridX = 0; gridX < static_cast<int>(gridSize.x); ++gridX)
             {
-                x = 0;
-                y++;
+                int x = 0, y = 0;
+                if(!mLayout.fromGrid(gridX, gridY, x, y)) continue;
+                
+                const sf::Uint32 tileGID = tileGIDs[y * mCols + x];
+                if(tileGID) addTileToLayer(layer, x, y, tileGID);
             }
         }
     }
+    layer.gids.swap(tileGIDs);
     
     // parse any layer properties
     if(pugi::xml_node propertiesNode = layerNode.child("properties"))
         parseLayerProperties(propertiesNode, layer);
-        
-    // TODO convert layer tile coords to isometric if needed
     
-    mLayers.push_back(layer);
+    mLayers.push_back(std::move(layer));
     return true;
 }
 
@@ -628,7 +1063,7 @@ bool TileMap::parseObjectGroup(const pugi::xml_node& groupNode)
     }
     
     // add layer to map layers.
-    MapLayer layer(tmx::ObjectGroup);
+    MapLayer layer(tmx::ObjectGroup, &mStrings);
     
     layer.name = groupNode.attribute("name").as_string();
     if(groupNode.attribute("opacity")) layer.opacity = groupNode.attribute("opacity").as_float();
@@ -640,6 +1075,10 @@ bool TileMap::parseObjectGroup(const pugi::xml_node& groupNode)
     // NOTE we push layer onto the vector at the end of the function in case we add any objects
     // with tile data to the layer's tiles property.
     
+    // isometric object coordinates run along the axes of the grid, so shapes are converted point
+    // by point and become diamonds and skewed polygons in the world
+    const bool isometric = mLayout.getOrientation() == tmx::Isometric;
+    
     // parse all object nodes into MapObjects
     while(objectNode)
     {
@@ -649,12 +1088,19 @@ bool TileMap::parseObjectGroup(const pugi::xml_node& groupNode)
             unLoad();
             return false;
         }
-        MapObject object;
+        MapObject object(&mStrings);
         
         // set position
         sf::Vector2f position(objectNode.attribute("x").as_float(),
                               objectNode.attribute("y").as_float());
-        object.setPosition(position);
+        const sf::Vector2f worldPosition = mLayout.objectPosition(position);
+        object.setPosition(worldPosition);
+        
+        // adds a point given relative to the object in tiled's object coordinates
+        auto addPoint = [&](const sf::Vector2f& point)
+        {
+            object.addPoint(isometric ? mLayout.objectPosition(position + point) - worldPosition : point);
+        };
         
         // set size if specified
         if(objectNode.attribute("width") && objectNode.attribute("height"))
@@ -671,18 +1117,21 @@ bool TileMap::parseObjectGroup(const pugi::xml_node& groupNode)
                 for(float angle = 0.f; angle < tau; angle += step)
                 {
                     sf::Vector2f point(x + x * cos(angle), y + y * sin(angle));
-                    object.addPoint(point);
+                    addPoint(point);
                 }
                 
-                if(size.x == size.y) object.setShapeType(Circle);
+                if(size.x == size.y && !isometric) object.setShapeType(Circle);
                 else object.setShapeType(Ellipse);
             }
             else // add points for rectangle to use in intersection testing
             {
-                object.addPoint(sf::Vector2f());
-                object.addPoint(sf::Vector2f(size.x, 0.f));
-                object.addPoint(sf::Vector2f(size.x, size.y));
-                object.addPoint(sf::Vector2f(0.f, size.y));
+                addPoint(sf::Vector2f());
+                addPoint(sf::Vector2f(size.x, 0.f));
+                addPoint(sf::Vector2f(size.x, size.y));
+                addPoint(sf::Vector2f(0.f, size.y));
+                
+                // the centre of an isometric rectangle is found from its points rather than its size
+                if(isometric) object.setShapeType(Polygon);
             }
             object.setSize(size);
         }
@@ -718,7 +1167,7 @@ bool TileMap::parseObjectGroup(const pugi::xml_node& groupNode)
                         if(coordstream.peek() == ',')
                             coordstream.ignore();
                     }
-                    object.addPoint(sf::Vector2f(coords[0], coords[1]));
+                    addPoint(sf::Vector2f(coords[0], coords[1]));
                 }
             }
             else
@@ -758,15 +1207,28 @@ bool TileMap::parseObjectGroup(const pugi::xml_node& groupNode)
             sf::Uint32 gid = objectNode.attribute("gid").as_int();
             
             LOG_INF("Found object with tile GID " + gid);
-            object.move(0.f, static_cast<float>(-mTileHeight)); // offset for tile origins being at the bottom in tiled.
-            const sf::Uint16 x = static_cast<sf::Uint16>(object.getPosition().x / mTileWidth);
-            const sf::Uint16 y = static_cast<sf::Uint16>(object.getPosition().y / mTileHeight);
+            TileInfo info = mTileInfo[gid];
+            
+            // offset for tile origins being at the bottom in tiled, which is the bottom middle of tiles on isometric maps.
+            // isometric tiles are added to the layer at the tile the object stands on, so they're drawn in its patch.
+            sf::Uint16 x = 0u, y = 0u;
+            if(isometric)
+            {
+                object.move(-info.size.x / 2.f, static_cast<float>(-mTileHeight));
+                x = static_cast<sf::Uint16>(std::min(std::max(position.x / mTileHeight, 0.f), static_cast<float>(mCols - 1u)));
+                y = static_cast<sf::Uint16>(std::min(std::max(position.y / mTileHeight, 0.f), static_cast<float>(mRows - 1u)));
+            }
+            else
+            {
+                object.move(0.f, static_cast<float>(-mTileHeight));
+                x = static_cast<sf::Uint16>(object.getPosition().x / mTileWidth);
+                y = static_cast<sf::Uint16>(object.getPosition().y / mTileHeight);
+            }
             
-            sf::Vector2f offset((object.getPosition().x - (x * mTileWidth)), (object.getPosition().y - (y * mTileHeight)));
+            sf::Vector2f offset = object.getPosition() - mLayout.tilePosition(x, y);
             object.setQuad(addTileToLayer(layer, x, y, gid, offset));
             object.setShapeType(Tile);
             
-            TileInfo info = mTileInfo[gid];
             // create bounding poly
             float width = static_cast<float>(info.size.x);
             float height = static_cast<float>(info.size.y);
@@ -797,7 +1259,7 @@ bool TileMap::parseObjectGroup(const pugi::xml_node& groupNode)
             debugColor = sf::Color(127u, 127u, 127u);
         }
         debugColor.a = static_cast<sf::Uint8>(255.f * layer.opacity);
-        object.createDebugShape(debugColor);
+        object.createShape(debugColor);
         
         // creates line segments from any available points
         object.createSegments();
@@ -825,29 +1287,30 @@ bool TileMap::parsetImageLayer(const pugi::xml_node& imageLayerNode)
     }
     
     std::string imageName = imageNode.attribute("source").as_string();
-    sf::Image image = loadImage(resourcePath() + imageName);
-    if(mFailedImage)
-    {
-        LOG_ERR("Failed to load image at " + imageName);
-        return false;
-    }
+    ImageSource source;
+    source.path = resourcePath() + imageName;
     
     // set transparency if required
     if(imageNode.attribute("trans"))
     {
-        image.createMaskFromColor(colorFromHex(imageNode.attribute("trans").as_string()));
+        source.masked = true;
+        source.mask = colorFromHex(imageNode.attribute("trans").as_string());
     }
     
     // load image to texture
-    std::unique_ptr<sf::Texture> texture(new sf::Texture);
-    texture->loadFromImage(image);
-    mImageLayerTextures.push_back(std::move(texture));
+    if(!loadTexture(source, mImageLayerTextures))
+    {
+        LOG_ERR("Failed to load image at " + imageName);
+        return false;
+    }
+    mImageLayerImages.push_back(source);
+    mDependencies.push_back(source.path);
     
     // Add texture to layer as sprite, set layer properties
     MapTile tile;
     tile.sprite.setTexture(*mImageLayerTextures.back());
     
-    MapLayer layer(tmx::ImageLayer);
+    MapLayer layer(tmx::ImageLayer, &mStrings);
     layer.name = imageLayerNode.attribute("name").as_string();
     if(imageLayerNode.attribute("opacity"))
     {
@@ -874,37 +1337,34 @@ void TileMap::parseLayerProperties(const pugi::xml_node& propertiesNode, MapLaye
 	{
 		std::string name = propertyNode.attribute("name").as_string();
 		std::string value = propertyNode.attribute("value").as_string();
-		destLayer.properties[name] = value;
+		destLayer.properties.set(name, value);
 		propertyNode = propertyNode.next_sibling("property");
 		LOG_INF("Added layer property " + name + " with value " + value);
 	}
 }
 
-TileQuad* TileMap::addTileToLayer(MapLayer& layer, sf::Uint16 x, sf::Uint16 y, sf::Uint32 gid, const sf::Vector2f& offset)
+sf::Uint16 TileMap::createTileVertices(float opacity, sf::Uint16 x, sf::Uint16 y, sf::Uint32 gid, const sf::Vector2f& offset, std::array<sf::Vertex, 4u>& vertices) const
 {
-    sf::Uint8 opacity = static_cast<sf::Uint8>(255.f * layer.opacity);
-    sf::Color color = sf::Color(255u, 255u, 255u, opacity);
-    
-    // Get bits and tile id
-    std::pair<sf::Uint32, std::bitset<3>> idAndFlags = resolveRotation(gid);
-    gid = idAndFlags.first;
+    sf::Color color = sf::Color(255u, 255u, 255u, static_cast<sf::Uint8>(255.f * opacity));
     
-    // update the layer's tile set(s)
-    sf::Vertex v0, v1, v2, v3;
+    const std::array<sf::Vector2f, 4u> texCoords = tileTexCoords(gid);
+    gid &= ~FlipFlags;
     
-    // applying half pixel trick avoid artifacting when scrolling
-    v0.texCoords = mTileInfo[gid].coords[0] + sf::Vector2f(0.5f, 0.5f);
-    v1.texCoords = mTileInfo[gid].coords[1] + sf::Vector2f(-0.5f, 0.5f);
-    v2.texCoords = mTileInfo[gid].coords[2] + sf::Vector2f(-0.5f, -0.5f);
-    v3.texCoords = mTileInfo[gid].coords[3] + sf::Vector2f(0.5f, -0.5f);
+    sf::Vertex& v0 = vertices[0];
+    sf::Vertex& v1 = vertices[1];
+    sf::Vertex& v2 = vertices[2];
+    sf::Vertex& v3 = vertices[3];
     
-    // flip texture coordinates according to bits set
-    doFlips(idAndFlags.second, &v0.texCoords, &v1.texCoords, &v2.texCoords, &v3.texCoords);
+    v0.texCoords = texCoords[0];
+    v1.texCoords = texCoords[1];
+    v2.texCoords = texCoords[2];
+    v3.texCoords = texCoords[3];
     
-    v0.position = sf::Vector2f(static_cast<float>(mTileWidth * x), static_cast<float>(mTileHeight * y));
-    v1.position = sf::Vector2f(static_cast<float>(mTileWidth * x) + mTileInfo[gid].size.x, static_cast<float>(mTileHeight * y));
-    v2.position = sf::Vector2f(static_cast<float>(mTileWidth * x) + mTileInfo[gid].size.x, static_cast<float>(mTileHeight * y) + mTileInfo[gid].size.y);
-    v3.position = sf::Vector2f(static_cast<float>(mTileWidth * x), static_cast<float>(mTileHeight * y) + mTileInfo[gid].size.y);
+    const sf::Vector2f position = mLayout.tilePosition(x, y);
+    v0.position = position;
+    v1.position = position + sf::Vector2f(mTileInfo[gid].size.x, 0.f);
+    v2.position = position + mTileInfo[gid].size;
+    v3.position = position + sf::Vector2f(0.f, mTileInfo[gid].size.y);
     
     // offset tiles with size not equal to map grid size
     sf::Uint16 tileHeight = static_cast<sf::Uint16>(mTileInfo[gid].size.y);
@@ -916,9 +1376,7 @@ TileQuad* TileMap::addTileToLayer(MapLayer& layer, sf::Uint16 x, sf::Uint16 y, s
         v2.position.y += diff;
         v3.position.y += diff;
     }
-    
-    // TODO adjust position for isometic maps
-    
+
     v0.color = color;
     v1.color = color;
     v2.color = color;
@@ -929,17 +1387,226 @@ TileQuad* TileMap::addTileToLayer(MapLayer& layer, sf::Uint16 x, sf::Uint16 y, s
     v2.position += offset;
     v3.position += offset;
     
-    sf::Uint16 id = mTileInfo[gid].tilesetId;
+    return mTileInfo[gid].tilesetId;
+}
+
+std::array<sf::Vector2f, 4u> TileMap::tileTexCoords(sf::Uint32 gid) const
+{
+    // Get bits and tile id
+    std::pair<sf::Uint32, std::bitset<3>> idAndFlags = resolveRotation(gid);
+    const TileInfo& info = mTileInfo[idAndFlags.first];
+    
+    // applying half pixel trick avoid artifacting when scrolling
+    std::array<sf::Vector2f, 4u> coords;
+    coords[0] = info.coords[0] + sf::Vector2f(0.5f, 0.5f);
+    coords[1] = info.coords[1] + sf::Vector2f(-0.5f, 0.5f);
+    coords[2] = info.coords[2] + sf::Vector2f(-0.5f, -0.5f);
+    coords[3] = info.coords[3] + sf::Vector2f(0.5f, -0.5f);
+    
+    // flip texture coordinates according to bits set
+    doFlips(idAndFlags.second, &coords[0], &coords[1], &coords[2], &coords[3]);
+    return coords;
+}
+
+std::shared_ptr<LayerSet> TileMap::createLayerSet(sf::Uint16 tilesetId) const
+{
+    std::shared_ptr<LayerSet> set = std::make_shared<LayerSet>(*mTilesetTextures[tilesetId], mPatchSize, mLayout);
+    set->setMergePatches(mMergePatches);
+    return set;
+}
+
+TileQuad* TileMap::addTileToLayer(MapLayer& layer, sf::Uint16 x, sf::Uint16 y, sf::Uint32 gid, const sf::Vector2f& offset)
+{
+    std::array<sf::Vertex, 4u> v;
+    sf::Uint16 id = createTileVertices(layer.opacity, x, y, gid, offset, v);
+    
+    // update the layer's tile set(s)
     if(layer.layerSets.find(id) == layer.layerSets.end())
     {
         // create a new layerset for texture
-        layer.layerSets.insert(std::make_pair(id, std::make_shared<LayerSet>(*mTilesetTextures[id], mPatchSize, sf::Vector2u(mCols, mRows), sf::Vector2u(mTileWidth, mTileHeight))));
+        layer.layerSets.insert(std::make_pair(id, createLayerSet(id)));
     }
     
     // add tile to set
-    return layer.layerSets[id]->addTile(v0, v1, v2, v3, x, y);
+    LayerSet& set = *layer.layerSets[id];
+    TileQuad* quad = set.addTile(v[0], v[1], v[2], v[3], x, y);
+    
+    // index animated tiles so frame changes only touch their quads.
+    // layers are added to the map once parsed, so the layer's index will be the current layer count.
+    trackAnimatedTile(quad, gid, static_cast<sf::Uint16>(mLayers.size()), id, set);
+    
+    return quad;
+}
+
+void TileMap::trackAnimatedTile(TileQuad* quad, sf::Uint32 gid, sf::Uint16 layer, sf::Uint16 tileset, const LayerSet& set)
+{
+    auto animation = mAnimations.find(gid & ~FlipFlags);
+    if(animation == mAnimations.end()) return;
+    
+    AnimatedTile tile;
+    tile.quad = quad;
+    tile.gid = gid;
+    tile.layer = layer;
+    tile.tileset = tileset;
+    tile.quadIndex = set.getQuadIndex(quad);
+    animation->second.tiles.push_back(tile);
+    
+    // tiles added while the animation is running start on its current frame
+    const TileAnimation& a = animation->second;
+    if(a.currentFrame < a.frames.size())
+        quad->setTextureCoords(tileTexCoords(a.frames[a.currentFrame].gid | (gid & FlipFlags)));
+}
+
+void TileMap::untrackAnimatedTile(TileQuad* quad, sf::Uint32 gid)
+{
+    auto animation = mAnimations.find(gid & ~FlipFlags);
+    if(animation == mAnimations.end()) return;
+    
+    auto& tiles = animation->second.tiles;
+    auto tile = std::find_if(tiles.begin(), tiles.end(), [quad](const AnimatedTile& t){ return t.quad == quad; });
+    if(tile != tiles.end())
+    {
+        *tile = tiles.back();
+        tiles.pop_back();
+    }
+}
+
+void TileMap::indexLayerQuads(MapLayer& layer)
+{
+    // each set's quads were added in the row order of the patch grid, so counting the tiles
+    // of each tileset in the same order finds the quad drawing each tile
+    layer.tileQuads.assign(layer.gids.size(), nullptr);
+    std::map<sf::Uint16, sf::Uint32> counts;
+    const sf::Vector2u& gridSize = mLayout.getGridSize();
+    for(int gridY = 0; gridY < static_cast<int>(gridSize.y); ++gridY)
+    {
+        for(int gridX = 0; gridX < static_cast<int>(gridSize.x); ++gridX)
+        {
+            int x = 0, y = 0;
+            if(!mLayout.fromGrid(gridX, gridY, x, y)) continue;
+            
+            const std::size_t i = y * mCols + x;
+            if(!layer.gids[i]) continue;
+            
+            const sf::Uint16 id = mTileInfo[layer.gids[i] & ~FlipFlags].tilesetId;
+            auto set = layer.layerSets.find(id);
+            if(set != layer.layerSets.end())
+                layer.tileQuads[i] = set->second->getQuad(counts[id]++);
+        }
+    }
+}
+
+bool TileMap::setTile(sf::Uint16 layerIndex, sf::Uint16 x, sf::Uint16 y, sf::Uint32 gid)
+{
+    if(layerIndex >= mLayers.size() || mLayers[layerIndex].type != tmx::Layer || mLayers[layerIndex].gids.empty()
+    || x >= mCols || y >= mRows || (gid & ~FlipFlags) >= mTileInfo.size())
+        return false;
+    
+    MapLayer& layer = mLayers[layerIndex];
+    const std::size_t cell = y * mCols + x;
+    const sf::Uint32 oldGid = layer.gids[cell];
+    if(oldGid == gid) return true;
+    
+    if(mStreamer)
+    {
+        // the loader thread reads the gids so they're only changed with the build lock held
+        const sf::Vector2i grid = mLayout.toGrid(x, y);
+        const sf::Uint32 chunk = (grid.y / mPatchSize) * mChunkCount.x + (grid.x / mPatchSize);
+        {
+            sf::Lock lock(mStreamer->getBuildMutex());
+            layer.gids[cell] = gid;
+            mStreamer->invalidate(chunk);
+        }
+        if(!mCollisionGrid.empty()) mCollisionGrid.setSolid(x, y, isCollisionTile(cell));
+        
+        if(mChunks[chunk].resident && !mChunks[chunk].edited)
+        {
+            mChunks[chunk].edited = true;
+            mEditedChunks.push_back(chunk);
+        }
+        return true;
+    }
+    
+    if(layer.tileQuads.empty()) indexLayerQuads(layer);
+    layer.gids[cell] = gid;
+    if(!mCollisionGrid.empty()) mCollisionGrid.setSolid(x, y, isCollisionTile(cell));
+    
+    TileQuad*& quad = layer.tileQuads[cell];
+    const sf::Uint16 oldId = mTileInfo[oldGid & ~FlipFlags].tilesetId;
+    if(quad) untrackAnimatedTile(quad, oldGid);
+    
+    if(!gid)
+    {
+        if(quad) layer.layerSets[oldId]->removeTile(quad);
+        quad = nullptr;
+        return true;
+    }
+    
+    std::array<sf::Vertex, 4u> vertices;
+    const sf::Uint16 id = createTileVertices(layer.opacity, x, y, gid, sf::Vector2f(), vertices);
+    auto set = layer.layerSets.find(id);
+    if(quad && id == oldId)
+    {
+        // same texture so the quad is rewritten where it is
+        set->second->setTileVertices(quad, vertices);
+    }
+    else
+    {
+        if(quad) layer.layerSets[oldId]->removeTile(quad);
+        
+        if(set == layer.layerSets.end())
+        {
+            set = layer.layerSets.insert(std::make_pair(id, createLayerSet(id))).first;
+            set->second->cull(mBounds);
+        }
+        quad = set->second->addTile(vertices[0], vertices[1], vertices[2], vertices[3], x, y);
+    }
+    trackAnimatedTile(quad, gid, layerIndex, id, *set->second);
+    
+    return true;
+}
+
+bool TileMap::clearTile(sf::Uint16 layer, sf::Uint16 x, sf::Uint16 y)
+{
+    return setTile(layer, x, y, 0u);
+}
+
+sf::Time TileMap::stressTileEdits(sf::Uint16 layerIndex, sf::Uint32 edits, sf::Uint32 editsPerUpdate)
+{
+    if(layerIndex >= mLayers.size() || mLayers[layerIndex].type != tmx::Layer || mLayers[layerIndex].gids.empty()
+    || mTileInfo.size() < 2u || !editsPerUpdate)
+        return sf::Time::Zero;
+    
+    const std::vector<sf::Uint32> original = mLayers[layerIndex].gids;
+    const unsigned int lastGid = static_cast<unsigned int>(mTileInfo.size() - 1u);
+    
+    sf::Clock clock;
+    for(sf::Uint32 i = 0u; i < edits; ++i)
+    {
+        const sf::Uint16 x = static_cast<sf::Uint16>(tag::random(0u, mCols - 1u));
+        const sf::Uint16 y = static_cast<sf::Uint16>(tag::random(0u, mRows - 1u));
+        // clearing and refilling tiles adds and removes quads, the rest are rewritten in place
+        const sf::Uint32 gid = tag::random(0u, 3u) ? tag::random(1u, lastGid) : 0u;
+        setTile(layerIndex, x, y, gid);
+        
+        if((i + 1u) % editsPerUpdate == 0u) update(sf::Time::Zero);
+    }
+    update(sf::Time::Zero);
+    const sf::Time elapsed = clock.getElapsedTime();
+    
+    const float seconds = elapsed.asSeconds();
+    LOG_INF("Tile edit stress test: " + std::to_string(edits) + " edits in " + std::to_string(elapsed.asMilliseconds())
+            + "ms, " + std::to_string(seconds > 0.f ? static_cast<sf::Uint32>(edits / seconds) : edits) + " edits/s"
+            + (mMergePatches ? " (merged patches)" : ""));
+    
+    for(sf::Uint16 y = 0u; y < mRows; ++y)
+        for(sf::Uint16 x = 0u; x < mCols; ++x)
+            setTile(layerIndex, x, y, original[y * mCols + x]);
+    update(sf::Time::Zero);
+    
+    return elapsed;
 }
-void TileMap::flipY(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3)
+void TileMap::flipY(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3) const
 {
     //Flip Y
     sf::Vector2f tmp = *v0;
@@ -948,7 +1615,7 @@ void TileMap::flipY(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Ve
     v2->y = tmp.y ;
     v3->y = v2->y;
 }
-void TileMap::flipX(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3)
+void TileMap::flipX(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3) const
 {
     //Flip X
     sf::Vector2f tmp = *v0;
@@ -957,7 +1624,7 @@ void TileMap::flipX(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Ve
     v2->x = v3->x;
     v3->x = v0->x;
 }
-void TileMap::flipD(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3)
+void TileMap::flipD(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3) const
 {
     //Diaganol flip
     sf::Vector2f tmp = *v1;
@@ -966,7 +1633,7 @@ void TileMap::flipD(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Ve
     v3->x = tmp.x;
     v3->y = tmp.y;
 }
-void TileMap::doFlips(std::bitset<3> bits,sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3)
+void TileMap::doFlips(std::bitset<3> bits,sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3) const
 {
     //000 = no change
     //001 = vertical = swap y axis
@@ -1027,7 +1694,7 @@ void TileMap::doFlips(std::bitset<3> bits,sf::Vector2f *v0, sf::Vector2f *v1, sf
     }
 }
 
-std::vector<unsigned char> TileMap::intToBytes(sf::Uint32 paramInt)
+std::vector<unsigned char> TileMap::intToBytes(sf::Uint32 paramInt) const
 {
     std::vector<unsigned char> arrayOfByte(4);
     for(int i = 0; i < 4; i++)
@@ -1035,7 +1702,7 @@ std::vector<unsigned char> TileMap::intToBytes(sf::Uint32 paramInt)
     return arrayOfByte;
 }
 
-std::pair<sf::Uint32, std::bitset<3> > TileMap::resolveRotation(sf::Uint32 gid)
+std::pair<sf::Uint32, std::bitset<3> > TileMap::resolveRotation(sf::Uint32 gid) const
 {
     static const unsigned FLIPPED_HORIZONTALLY_FLAG = 0x80000000;
     static const unsigned FLIPPED_VERTICALLY_FLAG   = 0x40000000;
@@ -1058,39 +1725,220 @@ std::pair<sf::Uint32, std::bitset<3> > TileMap::resolveRotation(sf::Uint32 gid)
     return std::pair<sf::Uint32, std::bitset<3>>(tileGID, b);
 }
 
-void TileMap::createDebugGrid()
+void TileMap::updateStreaming(const sf::View& view, sf::Time dt)
 {
-// TODO isometric grid
-	sf::Color debugColour(0u, 0u, 0u, 120u);
-	float mapHeight = static_cast<float>(mTileHeight * mRows);
-	for(int x = 0; x <= mCols; x += 2)
-	{
-		float posX = static_cast<float>(x * mTileWidth);
-		mGridVertices.append(sf::Vertex(sf::Vector2f(posX, 0.f), debugColour));
-		mGridVertices.append(sf::Vertex(sf::Vector2f(posX, mapHeight), debugColour));
-		posX += static_cast<float>(mTileWidth);
-		mGridVertices.append(sf::Vertex(sf::Vector2f(posX, mapHeight), debugColour));
-		mGridVertices.append(sf::Vertex(sf::Vector2f(posX, 0.f), debugColour));
-		posX += static_cast<float>(mTileWidth);
-		mGridVertices.append(sf::Vertex(sf::Vector2f(posX, 0.f), debugColour));
-	}
-	float mapWidth = static_cast<float>(mTileWidth * mCols);
-	for(int y = 0; y <= mRows; y += 2)
-	{
-		float posY = static_cast<float>(y *mTileHeight);
-		mGridVertices.append(sf::Vertex(sf::Vector2f(0.f, posY), debugColour));
-		posY += static_cast<float>(mTileHeight);
-		mGridVertices.append(sf::Vertex(sf::Vector2f(0.f, posY), debugColour));
-		mGridVertices.append(sf::Vertex(sf::Vector2f(mapWidth, posY), debugColour));
-		posY += static_cast<float>(mTileHeight);
-		mGridVertices.append(sf::Vertex(sf::Vector2f(mapWidth, posY), debugColour));
-	}
+    if(!mStreamer) return;
+    
+    // swap in anything the loader thread finished since the last update
+    std::vector<MapChunk> finished;
+    mStreamer->collect(finished);
+    for(auto& chunk : finished)
+        addChunk(chunk);
+    
+    // rebuild resident chunks with edited tiles, once however many of their tiles changed
+    for(const auto index : mEditedChunks)
+    {
+        if(!mChunks[index].edited) continue;
+        
+        MapChunk chunk;
+        chunk.index = index;
+        buildChunk(chunk);
+        
+        const sf::Uint64 lastUsed = mChunks[index].lastUsed;
+        evictChunk(index);
+        addChunk(chunk);
+        mChunks[index].lastUsed = lastUsed;
+    }
+    mEditedChunks.clear();
+    
+    // estimate the scroll velocity from the view movement since the last update
+    const sf::Vector2f centre = view.getCenter();
+    sf::Vector2f velocity;
+    if(mStreamFrame > 0u && dt > sf::Time::Zero)
+        velocity = (centre - mLastStreamCentre) / dt.asSeconds();
+    mLastStreamCentre = centre;
+    ++mStreamFrame;
+    
+    // grow the view area in the direction of travel by the distance covered in the look ahead time
+    sf::Vector2f start = centre - view.getSize() / 2.f;
+    sf::Vector2f end = start + view.getSize();
+    const sf::Vector2f ahead = velocity * mStreamLookAhead;
+    if(ahead.x < 0.f) start.x += ahead.x; else end.x += ahead.x;
+    if(ahead.y < 0.f) start.y += ahead.y; else end.y += ahead.y;
+    
+    // convert to a range of chunks, with a border of one chunk so chunks arrive before they're seen.
+    // isometric views cover a diamond of chunks, so each row of chunks has its own range.
+    const sf::FloatRect area(start, end - start);
+    const int patchSize = mPatchSize;
+    auto toChunk = [patchSize](int cell){ return (cell < 0) ? -1 : cell / patchSize; };
+    int first = 0, last = 0;
+    mLayout.gridRows(area, first, last);
+    const int firstY = std::max(0, toChunk(first) - 1);
+    const int lastY = std::min(static_cast<int>(mChunkCount.y) - 1, toChunk(last) + 1);
+    
+    // mark resident chunks in range as used and request the rest, nearest the view first
+    std::vector<std::pair<float, sf::Uint32>> missing;
+    for(int y = firstY; y <= lastY; ++y)
+    {
+        mLayout.gridColumns(area, y * patchSize, (y + 1) * patchSize - 1, first, last);
+        const int firstX = std::max(0, toChunk(first) - 1);
+        const int lastX = std::min(static_cast<int>(mChunkCount.x) - 1, toChunk(last) + 1);
+        for(int x = firstX; x <= lastX; ++x)
+        {
+            const sf::Uint32 index = y * mChunkCount.x + x;
+            if(mChunks[index].resident)
+            {
+                mChunks[index].lastUsed = mStreamFrame;
+            }
+            else
+            {
+                const sf::Vector2i cell(x * patchSize, y * patchSize);
+                const sf::FloatRect bounds = mLayout.gridBounds(cell, cell + sf::Vector2i(patchSize - 1, patchSize - 1));
+                const float dx = bounds.left + bounds.width / 2.f - centre.x;
+                const float dy = bounds.top + bounds.height / 2.f - centre.y;
+                missing.push_back(std::make_pair(dx * dx + dy * dy, index));
+            }
+        }
+    }
+    std::sort(missing.begin(), missing.end());
+    
+    std::vector<sf::Uint32> requests(missing.size());
+    for(std::size_t i = 0u; i < missing.size(); ++i)
+        requests[i] = missing[i].second;
+    mStreamer->setRequests(requests);
+    
+    // release the least recently used chunks outside the range until back under budget
+    if(mResidentMemory > mStreamBudget)
+    {
+        std::vector<std::pair<sf::Uint64, sf::Uint32>> unused;
+        for(sf::Uint32 i = 0u; i < mChunks.size(); ++i)
+        {
+            if(mChunks[i].resident && mChunks[i].lastUsed < mStreamFrame)
+                unused.push_back(std::make_pair(mChunks[i].lastUsed, i));
+        }
+        std::sort(unused.begin(), unused.end());
+        
+        for(const auto& chunk : unused)
+        {
+            if(mResidentMemory <= mStreamBudget) break;
+            evictChunk(chunk.second);
+        }
+    }
+}
 
-	mGridVertices.setPrimitiveType(sf::LinesStrip);
+void TileMap::startStreaming()
+{
+    // chunks are patches of the patch grid, which is larger than the map for stepped maps
+    mChunkCount.x = (mLayout.getGridSize().x + mPatchSize - 1u) / mPatchSize;
+    mChunkCount.y = (mLayout.getGridSize().y + mPatchSize - 1u) / mPatchSize;
+    mChunks.assign(mChunkCount.x * mChunkCount.y, ChunkState());
+    mResidentMemory = 0u;
+    mStreamFrame = 0u;
+    
+    mStreamer.reset(new ChunkStreamer(std::bind(&TileMap::buildChunk, this, std::placeholders::_1)));
+    mStreamer->start();
+    
+    LOG_INF("Streaming " + std::to_string(mChunks.size()) + " map chunks.");
+}
+
+void TileMap::stopStreaming()
+{
+    // destroying the streamer waits for the loader thread to finish
+    mStreamer.reset();
+    mChunks.clear();
+    mEditedChunks.clear();
+    mResidentMemory = 0u;
+}
+
+void TileMap::buildChunk(MapChunk& chunk) const
+{
+    const int firstX = (chunk.index % mChunkCount.x) * mPatchSize;
+    const int firstY = (chunk.index / mChunkCount.x) * mPatchSize;
+    const int lastX = std::min(firstX + mPatchSize, static_cast<int>(mLayout.getGridSize().x));
+    const int lastY = std::min(firstY + mPatchSize, static_cast<int>(mLayout.getGridSize().y));
+    
+    std::array<sf::Vertex, 4u> vertices;
+    for(sf::Uint16 i = 0u; i < mLayers.size(); ++i)
+    {
+        const MapLayer& layer = mLayers[i];
+        if(layer.type != tmx::Layer || layer.gids.empty()) continue;
+        
+        const std::size_t firstPatch = chunk.patches.size();
+        // tiles are built in grid order so the chunk's patches are in draw order
+        for(int gridY = firstY; gridY < lastY; ++gridY)
+        {
+            for(int gridX = firstX; gridX < lastX; ++gridX)
+            {
+                int x = 0, y = 0;
+                if(!mLayout.fromGrid(gridX, gridY, x, y)) continue;
+                
+                const sf::Uint32 gid = layer.gids[y * mCols + x];
+                if(!gid) continue;
+                
+                const sf::Uint16 tileset = createTileVertices(layer.opacity, x, y, gid, sf::Vector2f(), vertices);
+                
+                // a layer rarely uses more than a couple of tilesets so a linear search will do
+                auto patch = std::find_if(chunk.patches.begin() + firstPatch, chunk.patches.end(),
+                    [tileset](const ChunkPatch& p){ return p.tileset == tileset; });
+                if(patch == chunk.patches.end())
+                {
+                    ChunkPatch newPatch;
+                    newPatch.layer = i;
+                    newPatch.tileset = tileset;
+                    newPatch.vertices.reserve((lastX - firstX) * (lastY - firstY) * 4u);
+                    chunk.patches.push_back(std::move(newPatch));
+                    patch = chunk.patches.end() - 1;
+                }
+                patch->vertices.insert(patch->vertices.end(), vertices.begin(), vertices.end());
+            }
+        }
+        
+        for(std::size_t p = firstPatch; p < chunk.patches.size(); ++p)
+            chunk.patches[p].vertices.shrink_to_fit();
+    }
+}
+
+void TileMap::addChunk(MapChunk& chunk)
+{
+    ChunkState& state = mChunks[chunk.index];
+    if(state.resident) return;
+    
+    const sf::Vector2u patch(chunk.index % mChunkCount.x, chunk.index / mChunkCount.x);
+    for(auto& p : chunk.patches)
+    {
+        MapLayer& layer = mLayers[p.layer];
+        auto set = layer.layerSets.find(p.tileset);
+        if(set == layer.layerSets.end())
+            set = layer.layerSets.insert(std::make_pair(p.tileset, createLayerSet(p.tileset))).first;
+        
+        state.memory += p.vertices.capacity() * sizeof(sf::Vertex);
+        set->second->setPatch(patch, p.vertices);
+        
+        // the patch may grow the set's bounds, so cull again or the new tiles stay hidden
+        // (or unmerged) until the view next moves
+        set->second->cull(mBounds);
+    }
+    state.resident = true;
+    state.lastUsed = mStreamFrame;
+    mResidentMemory += state.memory;
+}
+
+void TileMap::evictChunk(sf::Uint32 index)
+{
+    const sf::Vector2u patch(index % mChunkCount.x, index / mChunkCount.x);
+    for(auto& layer : mLayers)
+    {
+        if(layer.type != tmx::Layer) continue;
+        
+        for(auto& set : layer.layerSets)
+            set.second->clearPatch(patch);
+    }
+    
+    mResidentMemory -= mChunks[index].memory;
+    mChunks[index] = ChunkState();
 }
 
 
- 
 sf::Image& TileMap::loadImage(const std::string& imageName)
 {
     const auto i = mCachedImages.find(imageName);
@@ -1111,118 +1959,618 @@ sf::Image& TileMap::loadImage(const std::string& imageName)
     return *mCachedImages[imageName];
 }
    
-std::string TileMap::fileFromPath(const std::string& path)
+bool TileMap::loadTexture(const ImageSource& source, std::vector<std::unique_ptr<sf::Texture>>& dest)
 {
-    assert(!path.empty());
+    const sf::Image& cachedImage = loadImage(source.path);
+    if(mFailedImage) return false;
     
-    for(auto it = path.rbegin(); it != path.rend(); ++it)
+    std::unique_ptr<sf::Texture> texture(new sf::Texture);
+    if(source.masked)
     {
-        if(*it == '/' || *it == '\\')
+        // mask a copy so the cached image is left untouched for other tilesets
+        sf::Image image = cachedImage;
+        image.createMaskFromColor(source.mask);
+        texture->loadFromImage(image);
+    }
+    else
+    {
+        texture->loadFromImage(cachedImage);
+    }
+    dest.push_back(std::move(texture));
+    return true;
+}
+
+bool TileMap::buildAtlas()
+{
+    std::vector<sf::Vector2u> sizes;
+    for(const auto& source : mTilesetImages)
+        sizes.push_back(loadImage(source.path).getSize());
+    
+    tmx::AtlasLayout layout;
+    if(!tmx::packAtlas(sizes, sf::Texture::getMaximumSize(), AtlasPadding, layout))
+    {
+        // fall back to a texture per tileset
+        LOG_WRN("Tileset larger than the maximum texture size, tilesets not packed into an atlas.");
+        for(const auto& source : mTilesetImages)
         {
-            int pos = std::distance(path.rbegin(), it);
-            return path.substr(path.size() - pos);
+            if(!loadTexture(source, mTilesetTextures)) return false;
         }
+        return true;
     }
-    return path;
+    
+    if(!loadAtlasTextures(layout)) return false;
+    
+    // move each tile's texture coords to where its tileset was placed. Index 0 is the empty tile.
+    for(std::size_t i = 1u; i < mTileInfo.size(); ++i)
+    {
+        TileInfo& info = mTileInfo[i];
+        const tmx::AtlasLayout::Placement& placement = layout.placements[info.tilesetId];
+        const sf::Vector2f offset(static_cast<float>(placement.position.x), static_cast<float>(placement.position.y));
+        for(auto& coord : info.coords)
+            coord += offset;
+        info.tilesetId = placement.page;
+    }
+    
+    LOG_INF("Packed " + std::to_string(mTilesetImages.size()) + " tilesets into " + std::to_string(mTilesetTextures.size()) + " textures.");
+    return true;
 }
 
-sf::Color TileMap::colorFromHex(const char* hexStr) const
+bool TileMap::loadAtlasTextures(const tmx::AtlasLayout& layout)
 {
-    // TODO proper checking valid string length
-    unsigned int value, r, g, b;
-    std::stringstream input(hexStr);
-    input >> std::hex >> value;
+    // masked copies are reserved up front so pointers to them stay valid
+    std::vector<sf::Image> maskedImages;
+    maskedImages.reserve(mTilesetImages.size());
+    std::vector<const sf::Image*> images;
+    for(const auto& source : mTilesetImages)
+    {
+        const sf::Image& image = loadImage(source.path);
+        if(mFailedImage) return false;
+        
+        if(source.masked)
+        {
+            maskedImages.push_back(image);
+            maskedImages.back().createMaskFromColor(source.mask);
+            images.push_back(&maskedImages.back());
+        }
+        else
+        {
+            images.push_back(&image);
+        }
+    }
     
-    r = (value >> 16) & 0xff;
-    g = (value >> 8) & 0xff;
-    b = value & 0xff;
+    std::vector<sf::Image> pages;
+    tmx::createAtlasPages(layout, images, pages);
     
-    return sf::Color(r, g, b);
+    mTilesetTextures.clear();
+    for(const auto& page : pages)
+    {
+        std::unique_ptr<sf::Texture> texture(new sf::Texture);
+        if(!texture->loadFromImage(page)) return false;
+        mTilesetTextures.push_back(std::move(texture));
+    }
+    mAtlasLayout = layout;
+    return true;
 }
 
-bool TileMap::decompress(const char* source, std::vector<unsigned char>& dest, int inSize, int expectedSize)
+bool TileMap::loadCache(const std::string& path)
 {
-	if(!source)
-	{
-		LOG_ERR("Input string is empty, decompression failed.");
-		return false;
-	}
-
-	int currentSize = expectedSize;
-	//TODO switch to std::make_unique when compatible with all compilers
-	std::unique_ptr<unsigned char[]> byteArray(new unsigned char[expectedSize / sizeof(unsigned char)]);
-	z_stream stream;
-	stream.zalloc = Z_NULL;
-	stream.zfree = Z_NULL;
-	stream.opaque = Z_NULL;
-	stream.next_in = (Bytef*)source;
-	stream.avail_in = inSize;
-	stream.next_out = (Bytef*)byteArray.get();
-	stream.avail_out = expectedSize;
-
-	if(inflateInit2(&stream, 15 + 32) != Z_OK)
-	{
-		LOG_ERR("inflate 2 failed");
-		return false;
-	}
+    MappedFile cacheFile;
+    if(!cacheFile.open(path)) return false;
+    
+    CacheReader reader(cacheFile.data(), cacheFile.size());
+    
+    // reject caches written by another version, or on a machine with a different data layout
+    sf::Uint32 magic = 0u, version = 0u, vertexSize = 0u;
+    sf::Uint16 byteOrder = 0u;
+    sf::Uint8 patchSize = 0u, streaming = 0u, atlas = 0u;
+    if(!reader.read(magic) || magic != CacheMagic
+    || !reader.read(version) || version != tmx::CacheVersion
+    || !reader.read(vertexSize) || vertexSize != sizeof(sf::Vertex)
+    || !reader.read(byteOrder) || byteOrder != 1u
+    || !reader.read(patchSize) || patchSize != mPatchSize
+    || !reader.read(streaming) || streaming != static_cast<sf::Uint8>(mStreaming)
+    || !reader.read(atlas) || atlas != static_cast<sf::Uint8>(mAtlasEnabled))
+    {
+        LOG_INF("Map cache <" + path + "> is not compatible, ignoring.");
+        return false;
+    }
+    
+    // the cache is stale if any file it was built from has changed
+    sf::Uint32 dependencyCount = 0u;
+    if(!reader.read(dependencyCount)) return false;
+    for(sf::Uint32 i = 0u; i < dependencyCount; ++i)
+    {
+        std::string file;
+        sf::Uint64 cachedHash = 0u, currentHash = 0u;
+        if(!reader.read(file) || !reader.read(cachedHash)) return false;
+        
+        if(!tmx::hashFile(file, currentHash) || currentHash != cachedHash)
+        {
+            LOG_INF("Map cache <" + path + "> is out of date, <" + file + "> has changed.");
+            return false;
+        }
+        mDependencies.push_back(file);
+    }
+    
+    sf::Uint8 orientation = 0u, staggerX = 0u, staggerEven = 0u;
+    if(!reader.read(mTileWidth) || !reader.read(mTileHeight)
+    || !reader.read(mCols) || !reader.read(mRows)
+    || !reader.read(orientation) || orientation > tmx::SteppedIsometric
+    || !reader.read(staggerX) || !reader.read(staggerEven)
+    || !reader.read(mProperties))
+        return false;
+    mLayout = tmx::TileLayout(static_cast<tmx::MapOrientation>(orientation), sf::Vector2u(mCols, mRows),
+                              sf::Vector2u(mTileWidth, mTileHeight), staggerX != 0u, staggerEven != 0u);
+    
+    // tileset and image layer textures are recreated from their source images.
+    // tilesets packed into an atlas are loaded below, once the atlas layout has been read.
+    std::vector<ImageSource>* sources[] = { &mTilesetImages, &mImageLayerImages };
+    std::vector<std::unique_ptr<sf::Texture>>* textures[] = { &mTilesetTextures, &mImageLayerTextures };
+    for(int i = 0; i < 2; ++i)
+    {
+        sf::Uint32 count = 0u;
+        if(!reader.read(count)) return false;
+        for(sf::Uint32 j = 0u; j < count; ++j)
+        {
+            ImageSource source;
+            sf::Uint8 masked = 0u;
+            if(!reader.read(source.path) || !reader.read(masked) || !reader.read(source.mask)) return false;
+            source.masked = (masked != 0u);
+            
+            if(i == 0 && mAtlasEnabled)
+            {
+                sources[i]->push_back(source);
+                continue;
+            }
+            
+            if(!loadTexture(source, *textures[i]))
+            {
+                LOG_ERR("Failed to load cached map image " + source.path);
+                return false;
+            }
+            sources[i]->push_back(source);
+        }
+    }
+    
+    if(mAtlasEnabled)
+    {
+        tmx::AtlasLayout layout;
+        if(!reader.readArray(layout.placements) || !reader.readArray(layout.pageSizes)) return false;
+        
+        // an empty layout means the tilesets were too large to pack when the cache was written
+        if(layout.pageSizes.empty())
+        {
+            for(const auto& source : mTilesetImages)
+            {
+                if(!loadTexture(source, mTilesetTextures)) return false;
+            }
+        }
+        else
+        {
+            // the atlas must fit on this machine's GPU and hold every tileset
+            if(layout.placements.size() != mTilesetImages.size()) return false;
+            for(const auto& placement : layout.placements)
+            {
+                if(placement.page >= layout.pageSizes.size()) return false;
+            }
+            for(const auto& size : layout.pageSizes)
+            {
+                if(size.x > sf::Texture::getMaximumSize() || size.y > sf::Texture::getMaximumSize()) return false;
+            }
+            if(!loadAtlasTextures(layout)) return false;
+        }
+    }
+    
+    if(!reader.readArray(mTileInfo)) return false;
+    for(const auto& info : mTileInfo)
+    {
+        if(info.tilesetId >= mTilesetTextures.size()) return false;
+    }
+    
+    sf::Uint32 tilePropertyCount = 0u;
+    if(!reader.read(tilePropertyCount)) return false;
+    for(sf::Uint32 i = 0u; i < tilePropertyCount; ++i)
+    {
+        sf::Uint32 gid = 0u;
+        if(!reader.read(gid) || !reader.read(mTileProperties[gid])) return false;
+    }
+    
+    sf::Uint32 layerCount = 0u;
+    if(!reader.read(layerCount)) return false;
+    for(sf::Uint32 i = 0u; i < layerCount; ++i)
+    {
+        if(!readCacheLayer(reader)) return false;
+    }
+    
+    sf::Uint32 animationCount = 0u;
+    if(!reader.read(animationCount)) return false;
+    for(sf::Uint32 i = 0u; i < animationCount; ++i)
+    {
+        sf::Uint32 gid = 0u, tileCount = 0u;
+        TileAnimation animation;
+        if(!reader.read(gid) || !reader.readArray(animation.frames) || !reader.read(tileCount)) return false;
+        
+        for(const auto& frame : animation.frames)
+        {
+            if(frame.gid >= mTileInfo.size()) return false;
+            animation.totalDuration += frame.duration;
+        }
+        if(animation.totalDuration == 0u) return false;
+        
+        for(sf::Uint32 j = 0u; j < tileCount; ++j)
+        {
+            AnimatedTile tile;
+            if(!reader.read(tile.gid) || !reader.read(tile.layer) || !reader.read(tile.tileset) || !reader.read(tile.quadIndex)
+            || tile.layer >= mLayers.size())
+                return false;
+            
+            // relink the quad from where it was in the cached layer sets
+            auto set = mLayers[tile.layer].layerSets.find(tile.tileset);
+            tile.quad = (set != mLayers[tile.layer].layerSets.end()) ? set->second->getQuad(tile.quadIndex) : nullptr;
+            if(!tile.quad) return false;
+            animation.tiles.push_back(tile);
+        }
+        mAnimations[gid] = animation;
+    }
+    
+    if(!reader.good()) return false;
+    
+    LOG_INF("Restored " + std::to_string(mLayers.size()) + " layers from cache.");
+    return true;
+}
 
-	int result = 0;
-	do
-	{
-		result = inflate(&stream, Z_SYNC_FLUSH);
-
-		switch(result)
-		{
-		case Z_NEED_DICT:
-		case Z_STREAM_ERROR:
-			result = Z_DATA_ERROR;
-		case Z_DATA_ERROR:
-		case Z_MEM_ERROR:
-			inflateEnd(&stream);
-			LOG_ERR(std::to_string(result));
-			return false;
-		}
-
-		if(result != Z_STREAM_END)
-		{
-			int oldSize = currentSize;
-			currentSize *= 2;
-			std::unique_ptr<unsigned char[]> newArray(new unsigned char[currentSize / sizeof(unsigned char)]);
-			std::memcpy(newArray.get(), byteArray.get(), currentSize / 2);
-			byteArray = std::move(newArray);
-			
-			stream.next_out = (Bytef*)(byteArray.get() + oldSize);
-			stream.avail_out = oldSize;
-
-		}
-	}
-	while(result != Z_STREAM_END);
+bool TileMap::readCacheLayer(CacheReader& reader)
+{
+    sf::Uint8 type = 0u, visible = 0u;
+    if(!reader.read(type) || type > tmx::ImageLayer) return false;
+    
+    MapLayer layer(static_cast<tmx::MapLayerType>(type), &mStrings);
+    sf::Uint32 setCount = 0u;
+    if(!reader.read(layer.name) || !reader.read(layer.opacity) || !reader.read(visible)
+    || !layer.properties.readCache(reader) || !reader.readArray(layer.gids) || !reader.read(setCount))
+        return false;
+    if(!layer.gids.empty() && (layer.gids.size() != mCols * mRows || !gidsInRange(layer.gids, mTileInfo.size())))
+        return false;
+    layer.visible = (visible != 0u);
+    
+    // patch vertices are copied straight out of the cache, ready to draw
+    for(sf::Uint32 i = 0u; i < setCount; ++i)
+    {
+        sf::Uint16 id = 0u;
+        if(!reader.read(id) || id >= mTilesetTextures.size()) return false;
+        
+        std::shared_ptr<LayerSet> set = createLayerSet(id);
+        if(!set->readCache(reader)) return false;
+        layer.layerSets[id] = set;
+    }
+    
+    sf::Uint32 tileCount = 0u;
+    if(!reader.read(tileCount)) return false;
+    for(sf::Uint32 i = 0u; i < tileCount; ++i)
+    {
+        sf::Uint32 index = 0u;
+        sf::Color color;
+        sf::Vector2f position;
+        if(!reader.read(index) || !reader.read(color) || !reader.read(position)
+        || index >= mImageLayerTextures.size())
+            return false;
+        
+        MapTile tile;
+        tile.sprite.setTexture(*mImageLayerTextures[index]);
+        tile.sprite.setColor(color);
+        tile.sprite.setPosition(position);
+        layer.tiles.push_back(tile);
+    }
+    
+    sf::Uint32 objectCount = 0u;
+    if(!reader.read(objectCount)) return false;
+    for(sf::Uint32 i = 0u; i < objectCount; ++i)
+    {
+        MapObject object(&mStrings);
+        sf::Uint16 setId = 0u;
+        sf::Int32 quadIndex = -1;
+        if(!object.readCache(reader) || !reader.read(setId) || !reader.read(quadIndex)) return false;
+        
+        // relink tile objects to the quad drawing them
+        if(quadIndex >= 0)
+        {
+            auto set = layer.layerSets.find(setId);
+            TileQuad* quad = (set != layer.layerSets.end()) ? set->second->getQuad(quadIndex) : nullptr;
+            if(!quad) return false;
+            object.setQuad(quad);
+        }
+        layer.objects.push_back(object);
+    }
+    
+    mLayers.push_back(std::move(layer));
+    return true;
+}
 
-	if(stream.avail_in != 0)
-	{
-		LOG_ERR("stream.avail_in is 0");
-		LOG_ERR("zlib decompression failed.");
-		return false;
-	}
+void TileMap::writeCache(const std::string& path) const
+{
+    CacheWriter writer;
+    writer.write(CacheMagic);
+    writer.write(tmx::CacheVersion);
+    writer.write(static_cast<sf::Uint32>(sizeof(sf::Vertex)));
+    writer.write(static_cast<sf::Uint16>(1u)); // reads back as 1 only with the same byte order
+    writer.write(mPatchSize);
+    writer.write(static_cast<sf::Uint8>(mStreaming)); // streamed tile layers have no prebuilt vertices
+    writer.write(static_cast<sf::Uint8>(mAtlasEnabled));
+    
+    // key the cache on the contents of every file the map was built from
+    writer.write(static_cast<sf::Uint32>(mDependencies.size()));
+    for(const auto& file : mDependencies)
+    {
+        sf::Uint64 hash = 0u;
+        if(!tmx::hashFile(file, hash))
+        {
+            LOG_WRN("Unable to read <" + file + ">, map cache not written.");
+            return;
+        }
+        writer.write(file);
+        writer.write(hash);
+    }
+    
+    writer.write(mTileWidth);
+    writer.write(mTileHeight);
+    writer.write(mCols);
+    writer.write(mRows);
+    writer.write(static_cast<sf::Uint8>(mLayout.getOrientation()));
+    writer.write(static_cast<sf::Uint8>(mLayout.getStaggerX()));
+    writer.write(static_cast<sf::Uint8>(mLayout.getStaggerEven()));
+    writer.write(mProperties);
+    
+    const std::vector<ImageSource>* sources[] = { &mTilesetImages, &mImageLayerImages };
+    for(const auto& images : sources)
+    {
+        writer.write(static_cast<sf::Uint32>(images->size()));
+        for(const auto& source : *images)
+        {
+            writer.write(source.path);
+            writer.write(static_cast<sf::Uint8>(source.masked));
+            writer.write(source.mask);
+        }
+    }
+    
+    if(mAtlasEnabled)
+    {
+        writer.writeArray(mAtlasLayout.placements);
+        writer.writeArray(mAtlasLayout.pageSizes);
+    }
+    
+    writer.writeArray(mTileInfo);
+    
+    writer.write(static_cast<sf::Uint32>(mTileProperties.size()));
+    for(const auto& tile : mTileProperties)
+    {
+        writer.write(tile.first);
+        writer.write(tile.second);
+    }
+    
+    writer.write(static_cast<sf::Uint32>(mLayers.size()));
+    for(const auto& layer : mLayers)
+        writeCacheLayer(writer, layer);
+    
+    writer.write(static_cast<sf::Uint32>(mAnimations.size()));
+    for(const auto& animation : mAnimations)
+    {
+        writer.write(animation.first);
+        writer.writeArray(animation.second.frames);
+        writer.write(static_cast<sf::Uint32>(animation.second.tiles.size()));
+        for(const auto& tile : animation.second.tiles)
+        {
+            writer.write(tile.gid);
+            writer.write(tile.layer);
+            writer.write(tile.tileset);
+            writer.write(tile.quadIndex);
+        }
+    }
+    
+    if(writer.save(path))
+        LOG_INF("Wrote map cache <" + path + ">");
+    else
+        LOG_WRN("Failed to write map cache <" + path + ">");
+}
 
-	const int outSize = currentSize - stream.avail_out;
-	inflateEnd(&stream);
+void TileMap::writeCacheLayer(CacheWriter& writer, const MapLayer& layer) const
+{
+    writer.write(static_cast<sf::Uint8>(layer.type));
+    writer.write(layer.name);
+    writer.write(layer.opacity);
+    writer.write(static_cast<sf::Uint8>(layer.visible));
+    layer.properties.writeCache(writer);
+    writer.writeArray(layer.gids);
+    
+    writer.write(static_cast<sf::Uint32>(layer.layerSets.size()));
+    for(const auto& set : layer.layerSets)
+    {
+        writer.write(set.first);
+        set.second->writeCache(writer);
+    }
+    
+    // image layer sprites reference their texture by index
+    writer.write(static_cast<sf::Uint32>(layer.tiles.size()));
+    for(const auto& tile : layer.tiles)
+    {
+        sf::Uint32 index = 0u;
+        while(index < mImageLayerTextures.size() && mImageLayerTextures[index].get() != tile.sprite.getTexture())
+            ++index;
+        
+        writer.write(index);
+        writer.write(tile.sprite.getColor());
+        writer.write(tile.sprite.getPosition());
+    }
+    
+    // tile objects reference their quad by layer set and index within the set
+    std::map<const TileQuad*, std::pair<sf::Uint16, sf::Int32>> quadIds;
+    for(const auto& set : layer.layerSets)
+    {
+        sf::Uint32 i = 0u;
+        while(const TileQuad* quad = set.second->getQuad(i))
+        {
+            quadIds[quad] = std::make_pair(set.first, static_cast<sf::Int32>(i));
+            ++i;
+        }
+    }
+    
+    writer.write(static_cast<sf::Uint32>(layer.objects.size()));
+    for(const auto& object : layer.objects)
+    {
+        object.writeCache(writer);
+        
+        auto quad = quadIds.find(object.getQuad());
+        if(quad != quadIds.end())
+        {
+            writer.write(quad->second.first);
+            writer.write(quad->second.second);
+        }
+        else
+        {
+            writer.write(static_cast<sf::Uint16>(0u));
+            writer.write(static_cast<sf::Int32>(-1));
+        }
+    }
+}
 
-	std::unique_ptr<unsigned char[]> newArray(new unsigned char[outSize / sizeof(unsigned char)]);
-	std::memcpy(newArray.get(), byteArray.get(), outSize);
-	byteArray = std::move(newArray);
+std::string TileMap::fileFromPath(const std::string& path)
+{
+    assert(!path.empty());
+    
+    for(auto it = path.rbegin(); it != path.rend(); ++it)
+    {
+        if(*it == '/' || *it == '\\')
+        {
+            int pos = std::distance(path.rbegin(), it);
+            return path.substr(path.size() - pos);
+        }
+    }
+    return path;
+}
 
-	//copy bytes to vector
-	int length = currentSize / sizeof(unsigned char);	
-	dest.insert(dest.begin(), &byteArray[0], &byteArray[length]);
+sf::Color TileMap::colorFromHex(const char* hexStr) const
+{
+    // TODO proper checking valid string length
+    unsigned int value, r, g, b;
+    std::stringstream input(hexStr);
+    input >> std::hex >> value;
+    
+    r = (value >> 16) & 0xff;
+    g = (value >> 8) & 0xff;
+    b = value & 0xff;
+    
+    return sf::Color(r, g, b);
+}
 
-	return true;
+bool TileMap::decompress(const unsigned char* source, std::size_t inSize, std::vector<sf::Uint32>& dest, const std::string& compression)
+{
+    if(!source || inSize == 0u)
+    {
+        LOG_ERR("Input data is empty, decompression failed.");
+        return false;
+    }
+    
+    // decompressed bytes are written in place over the preallocated gids
+    unsigned char* out = reinterpret_cast<unsigned char*>(dest.data());
+    const std::size_t outSize = dest.size() * sizeof(sf::Uint32);
+    
+    if(compression == "zlib" || compression == "gzip")
+    {
+        z_stream stream;
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        stream.next_in = const_cast<Bytef*>(source);
+        stream.avail_in = static_cast<uInt>(inSize);
+        stream.next_out = out;
+        stream.avail_out = static_cast<uInt>(outSize);
+        
+        // 15 window bits + 32 enables automatic detection of zlib and gzip headers
+        if(inflateInit2(&stream, 15 + 32) != Z_OK)
+        {
+            LOG_ERR("inflate 2 failed");
+            return false;
+        }
+        
+        // the output size is known up front, so the stream is inflated in a single call
+        const int result = inflate(&stream, Z_FINISH);
+        const std::size_t written = outSize - stream.avail_out;
+        inflateEnd(&stream);
+        
+        if(result == Z_BUF_ERROR && stream.avail_out == 0u)
+        {
+            LOG_ERR("Decompressed layer data is larger than the map size.");
+            return false;
+        }
+        if(result != Z_STREAM_END)
+        {
+            LOG_ERR("zlib decompression failed with error " + std::to_string(result));
+            return false;
+        }
+        if(written != outSize)
+        {
+            LOG_ERR("Decompressed layer data is smaller than the map size.");
+            return false;
+        }
+        if(stream.avail_in != 0u)
+        {
+            LOG_ERR("Compressed layer data continues past the end of the stream.");
+            return false;
+        }
+        return true;
+    }
+    else if(compression == "zstd")
+    {
+#ifdef TAG_USE_ZSTD
+        // ZSTD_decompress would carry on into any further frames, so the input must be exactly one
+        const std::size_t frameSize = ZSTD_findFrameCompressedSize(source, inSize);
+        if(ZSTD_isError(frameSize) || frameSize != inSize)
+        {
+            LOG_ERR("Compressed layer data is not a single complete zstd frame.");
+            return false;
+        }
+        
+        const std::size_t written = ZSTD_decompress(out, outSize, source, inSize);
+        if(ZSTD_isError(written))
+        {
+            LOG_ERR("zstd decompression failed: " + std::string(ZSTD_getErrorName(written)));
+            return false;
+        }
+        if(written != outSize)
+        {
+            LOG_ERR("Decompressed layer data is smaller than the map size.");
+            return false;
+        }
+        return true;
+#else
+        LOG_ERR("zstd compressed layer found, but zstd support is not enabled. Define TAG_USE_ZSTD and link libzstd.");
+        return false;
+#endif
+    }
+    
+    LOG_ERR("Unsupported compression " + compression + " found.");
+    return false;
 }
 
 TileMap::TileInfo::TileInfo()
  : tilesetId(0u)
 {}
 
+TileMap::ImageSource::ImageSource()
+ : masked(false)
+{}
+
+TileMap::TileAnimation::TileAnimation()
+ : totalDuration(0u)
+ , currentFrame(std::numeric_limits<sf::Uint32>::max()) // forces the first update to set the frame
+{}
+
+TileMap::ChunkState::ChunkState()
+ : resident(false)
+ , lastUsed(0u)
+ , memory(0u)
+ , edited(false)
+{}
+
 TileMap::TileInfo::TileInfo(const sf::IntRect& rect, const sf::Vector2f& size, sf::Uint16 tilesetId)
  : size(size)
  , tilesetId(tilesetId)
@@ -1233,58 +2581,162 @@ TileMap::TileInfo::TileInfo(const sf::IntRect& rect, const sf::Vector2f& size, s
     coords[3] = sf::Vector2f(static_cast<float>(rect.left), static_cast<float>(rect.top + rect.height));
 }
 
-static const std::string base64Chars =
-				"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-				"abcdefghijklmnopqrstuvwxyz"
-				"0123456789+/";
-
-static inline bool isBase64(unsigned char c)
+namespace
 {
-	return (isalnum(c) || (c == '+') || (c == '/'));
-}
-
-static std::string base64Decode(std::string const& encoded_string)
-{
-	int in_len = encoded_string.size();
-	int i = 0;
-	int j = 0;
-	int in_ = 0;
-	unsigned char char_array_4[4], char_array_3[3];
-	std::string ret;
-
-	while (in_len-- && ( encoded_string[in_] != '=') && isBase64(encoded_string[in_]))
-	{
-		char_array_4[i++] = encoded_string[in_]; in_++;
-		if (i ==4)
-		{
-			for (i = 0; i <4; i++)
-				char_array_4[i] = base64Chars.find(char_array_4[i]);
-
-			char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-			char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-			char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-			for (i = 0; (i < 3); i++)
-				ret += char_array_3[i];
-			i = 0;
-		}
-	}
-
-	if (i)
-	{
-		for (j = i; j <4; j++)
-			char_array_4[j] = 0;
-
-		for (j = 0; j <4; j++)
-			char_array_4[j] = base64Chars.find(char_array_4[j]);
+    // values stored in the decode table for characters which are not part of the base64 alphabet
+    const unsigned char Base64Invalid = 0xff;
+    const unsigned char Base64Space = 0xfe;
+    
+    std::array<unsigned char, 256u> createBase64Table()
+    {
+        std::array<unsigned char, 256u> table;
+        table.fill(Base64Invalid);
+        
+        const std::string chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                  "abcdefghijklmnopqrstuvwxyz"
+                                  "0123456789+/";
+        for(unsigned int i = 0u; i < chars.size(); ++i)
+            table[static_cast<unsigned char>(chars[i])] = static_cast<unsigned char>(i);
+        
+        // whitespace created by newlines and tabs in the document is skipped while decoding
+        table[' '] = table['\t'] = table['\n'] = table['\r'] = Base64Space;
+        return table;
+    }
+    
+    // maps each input character directly to its 6 bit value
+    const std::array<unsigned char, 256u> base64Table = createBase64Table();
+    
+    bool base64Decode(const char* encoded, std::vector<unsigned char>& dest)
+    {
+        // size output for the worst case (no whitespace or padding), trimmed once decoded
+        const std::size_t length = std::strlen(encoded);
+        dest.resize(length / 4u * 3u + 3u);
+        
+        long size = base64Decode(encoded, dest.data(), dest.size());
+        if(size < 0) return false;
+        
+        dest.resize(size);
+        return true;
+    }
 
-		char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-		char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-		char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+    long base64Decode(const char* encoded, unsigned char* dest, std::size_t destSize)
+    {
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(encoded);
+        const unsigned char* end = in + std::strlen(encoded);
+        unsigned char* out = dest;
+        unsigned char* const outEnd = dest + destSize;
+        
+        sf::Uint32 quantum = 0u;
+        int count = 0;
+        
+        while(in < end)
+        {
+            // fast path: four characters from the alphabet decode to three bytes without branching per character
+            if(count == 0 && end - in >= 4)
+            {
+                const unsigned char a = base64Table[in[0]];
+                const unsigned char b = base64Table[in[1]];
+                const unsigned char c = base64Table[in[2]];
+                const unsigned char d = base64Table[in[3]];
+                if((a | b | c | d) < 64u && outEnd - out >= 3)
+                {
+                    const sf::Uint32 value = (a << 18) | (b << 12) | (c << 6) | d;
+                    out[0] = static_cast<unsigned char>(value >> 16);
+                    out[1] = static_cast<unsigned char>(value >> 8);
+                    out[2] = static_cast<unsigned char>(value);
+                    out += 3;
+                    in += 4;
+                    continue;
+                }
+            }
+        
+            // slow path: skip whitespace in place and gather a quantum one character at a time
+            const unsigned char value = base64Table[*in];
+            if(value < 64u)
+            {
+                quantum = (quantum << 6) | value;
+                if(++count == 4)
+                {
+                    if(outEnd - out < 3) return -1;
+                    out[0] = static_cast<unsigned char>(quantum >> 16);
+                    out[1] = static_cast<unsigned char>(quantum >> 8);
+                    out[2] = static_cast<unsigned char>(quantum);
+                    out += 3;
+                    quantum = 0u;
+                    count = 0;
+                }
+            }
+            else if(*in == '=')
+            {
+                break;
+            }
+            else if(value != Base64Space)
+            {
+                return -1;
+            }
+            ++in;
+        }
+        
+        // flush any partial quantum left before padding
+        if(count == 1 || outEnd - out < count - 1)
+        {
+            return -1;
+        }
+        else if(count == 2)
+        {
+            *out++ = static_cast<unsigned char>(quantum >> 4);
+        }
+        else if(count == 3)
+        {
+            *out++ = static_cast<unsigned char>(quantum >> 10);
+            *out++ = static_cast<unsigned char>(quantum >> 2);
+        }
+        
+        return static_cast<long>(out - dest);
+    }
 
-		for (j = 0; (j < i - 1); j++)
-			ret += char_array_3[j];
-	}
+    long parseCsv(const char* text, sf::Uint32* dest, std::size_t destCount)
+    {
+        std::size_t count = 0u;
+        const char* c = text;
+        while(true)
+        {
+            // skip separators and any whitespace created by newlines in the document
+            while(*c == ',' || *c == ' ' || *c == '\n' || *c == '\r' || *c == '\t') ++c;
+            if(*c == '\0') break;
+        
+            if(*c < '0' || *c > '9' || count == destCount) return -1;
+        
+            // accumulate in 64 bits so ids out of range are rejected rather than wrapped
+            sf::Uint64 value = 0u;
+            do
+            {
+                value = value * 10u + static_cast<sf::Uint64>(*c - '0');
+                if(value > 0xffffffffu) return -1;
+                ++c;
+            }
+            while(*c >= '0' && *c <= '9');
+        
+            dest[count++] = static_cast<sf::Uint32>(value);
+        }
+        return static_cast<long>(count);
+    }
 
-	return ret;
+    void gidsFromLittleEndian(std::vector<sf::Uint32>& gids)
+    {
+        const sf::Uint16 probe = 1u;
+        if(*reinterpret_cast<const unsigned char*>(&probe) == 1u) return; // already host order
+        
+        for(auto& gid : gids)
+            gid = (gid >> 24) | ((gid >> 8) & 0xff00) | ((gid << 8) & 0xff0000) | (gid << 24);
+    }
+    
+    bool gidsInRange(const std::vector<sf::Uint32>& gids, std::size_t tileCount)
+    {
+        for(const auto gid : gids)
+        {
+            if((gid & ~FlipFlags) >= tileCount) return false;
+        }
+        return true;
+    }
 }
\ No newline at end of file
@@ -5,14 +5,28 @@
 #include "MapLayer.hpp"
 #include "MapObject.hpp"
 #include "QuadTree.hpp"
+#include "TileAtlas.hpp"
+#include "CollisionGrid.hpp"
+#include "ObjectStore.hpp"
 
 #include "pugixml.hpp"
 
+class CacheWriter;
+class CacheReader;
+class MappedFile;
+class ChunkStreamer;
+struct MapChunk;
+namespace tmx
+{
+    class DebugDraw;
+}
+
 #include <SFML/Graphics/View.hpp>
 #include <SFML/Graphics/VertexArray.hpp>
 #include <SFML/Graphics/Image.hpp>
 #include <SFML/Graphics/Drawable.hpp>
 #include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
 
 #include <string>
 #include <list>
@@ -25,16 +39,6 @@
 class SceneNode;
 
 
-namespace tmx
-{
-    enum MapOrientation
-    {
-        Orthogonal,
-        Isometric,
-        SteppedIsometric
-    };
-}
-
 class TileMap : public sf::Drawable, private sf::NonCopyable
 {
 public:
@@ -48,6 +52,14 @@ public:
     std::vector<MapLayer>& getLayers();
 	const std::vector<MapLayer>& getLayers() const;
 	
+    //advances tile animations by dt and applies changes made to tiles since the last update, such
+    //as moved tile objects. Call once a frame before drawing, drawing only reads the map.
+    void update(sf::Time dt);
+    
+    //culls the map's tiles to those visible in view. The draw functions below do this for the target's
+    //view, call it before drawing the map with RenderTarget::draw, which only draws what was last culled.
+    void setDrawingBounds(const sf::View& view);
+    
     //draws visible tiles to given target, optionally draw outline of objects for debugging
     void draw(sf::RenderTarget& rt, MapLayer::DrawType type, bool debug = false);
     //overload for drawing layer by index
@@ -59,11 +71,31 @@ public:
 	unsigned int getNumRows() const;
 	unsigned int getMapWidth() const;
 	unsigned int getMapHeight() const;
+	//where tiles are placed for the map's orientation
+	const tmx::TileLayout& getLayout() const;
     
-	//loads a given tmx file, returns false on failure
+	//loads a given tmx file, returns false on failure. When caching is enabled a binary
+	//cache is written next to the map after parsing, and used instead of the xml on later
+	//loads as long as the tmx, tsx and image files it was built from are unchanged.
 	bool loadMap(const std::string& filename);
     void unLoad();
     
+    //enables or disables reading and writing of the binary map cache. Enabled by default.
+    void setCacheEnabled(bool enabled);
+    
+    //packs all tilesets into as few textures as the GPU's maximum texture size allows, so layers
+    //mixing tilesets are drawn with one layer set. Takes effect on the next loadMap.
+    void setAtlasEnabled(bool enabled);
+    
+    //enables streaming of tile layers, for maps too large to keep every vertex in memory. Only the
+    //gids of tile layers are kept, and the vertices of chunks of patchSize x patchSize tiles around
+    //the view are built on a background thread. Once more than memoryBudget bytes of vertices are
+    //resident the least recently visible chunks are released. Takes effect on the next loadMap.
+    void setStreaming(bool enabled, std::size_t memoryBudget = 32u * 1024u * 1024u, float lookAhead = 0.5f);
+    //call once a frame when streaming. Requests the chunks under the view, extended by the distance
+    //the view scrolls in lookAhead seconds at its current velocity, and swaps in finished chunks.
+    void updateStreaming(const sf::View& view, sf::Time dt);
+    
     // Updates the map's quad tree. Not necessary when not querying the quad tree.
     // root area is the area covered by the root node, for example the screen size.
     void updateQuadTree(const sf::FloatRect& rootArea);
@@ -73,11 +105,78 @@ public:
     
     bool quadTreeAvailable() const;
     
+    struct ObjectHit
+    {
+        MapObject* object; // nullptr if nothing was hit
+        sf::Vector2f normal;
+        float time; // fraction of the displacement moved before touching the object, from 0 to 1
+    };
+    struct ObjectSweep
+    {
+        sf::FloatRect box; // with no size to sweep a point, such as a bullet
+        sf::Vector2f displacement;
+    };
+    // moves box by displacement and fills hit with the first map object it would touch. Candidates are
+    // gathered from the quad tree when it's available, so objects outside its root area are missed, else
+    // every object is tested. Objects the box already overlaps are ignored. Returns false if nothing is hit.
+    bool sweepObjects(const sf::FloatRect& box, const sf::Vector2f& displacement, ObjectHit& hit);
+    // as above for a point moving from start to end
+    bool raycastObjects(const sf::Vector2f& start, const sf::Vector2f& end, ObjectHit& hit);
+    // runs many sweeps, such as every projectile of a frame, filling hits with a result for each one.
+    // Returns the number of sweeps which hit an object.
+    std::size_t sweepObjects(const std::vector<ObjectSweep>& sweeps, std::vector<ObjectHit>& hits);
+    
 	//sets the shader property of a layer's rendering states member
     void setLayerShader(sf::Uint16 layerId, const sf::Shader& shader);
     
+    //draw calls, patches and vertices the map's tile layers submit each time they're drawn with the
+    //current drawing bounds, to see how much of the map survives culling.
+    DrawStats getDrawStats() const;
+    
+    //draws the visible patches of each layer and tileset with a single draw call, at the cost of copying
+    //their vertices whenever the visible patches change. Applies to the current map and any loaded later.
+    void setMergePatches(bool merge);
+    
+    //changes the tile at x, y of a tile layer to gid, which may include flip flags. Only the tile's own
+    //quad is rewritten, or added to or removed from its patch. A gid of 0 clears the tile. When
+    //streaming the tile's chunk is rebuilt by the next updateStreaming. Returns false if the layer
+    //isn't a tile layer, or the position or gid is out of range.
+    bool setTile(sf::Uint16 layer, sf::Uint16 x, sf::Uint16 y, sf::Uint32 gid);
+    bool clearTile(sf::Uint16 layer, sf::Uint16 x, sf::Uint16 y);
+    //stress test for setTile: makes random edits to a tile layer, clearing about a quarter of the
+    //tiles, and updates the map every editsPerUpdate edits as a game would once a frame. Logs the edits
+    //per second and restores the layer afterwards. Call setMergePatches(true) first to test merged drawing.
+    //Returns the time spent editing and updating, or zero if the layer isn't a tile layer.
+    sf::Time stressTileEdits(sf::Uint16 layer, sf::Uint32 edits, sf::Uint32 editsPerUpdate = 100u);
+    
+    //builds a collision grid whenever a map is loaded, with a solid tile wherever the named tile layer
+    //has a tile. Replaces any collision property, an empty name disables the grid.
+    void setCollisionLayer(const std::string& layerName);
+    //builds a collision grid whenever a map is loaded, with a solid tile wherever any tile layer has a tile
+    //whose tileset sets the named property to anything but "false" or "0". Replaces any collision layer.
+    void setCollisionProperty(const std::string& propertyName);
+    //the collision grid of the current map, kept up to date by setTile. Empty if no collision
+    //layer or property is set, or the collision layer wasn't found. Only orthogonal maps have a
+    //grid, other maps fail to load while a collision layer or property is set.
+    const CollisionGrid& getCollisionGrid() const;
+    //also covers the solid tiles of the collision grid with as few rectangle MapObjects as it can, added
+    //to an object group named "Tile Collision" so the quad tree can be used for collision against tiles.
+    //The objects are created when the map is loaded and aren't changed by setTile.
+    void setCollisionObjects(bool enabled);
+    
+    //returns empty string if the tile has no such property
+    std::string getTilePropertyString(sf::Uint32 gid, const std::string& name) const;
+    
     //returns empty string if property not found
     std::string getPropertyString(const std::string& name);
+    
+    //the strings interned by the map's objects and layers. Look up a name or type here once, for example
+    //to filter objects by MapObject::getTypeId. Cleared when the map is unloaded.
+    const tmx::StringTable& getStrings() const;
+    
+    //the AABB, centre and radius of every object of the map packed by object id, for scanning many objects
+    //without touching their other data. Objects are found from their id with ObjectStore::getObject.
+    const tmx::ObjectStore& getObjectStore() const;
 protected:
 	unsigned int mTileWidth;
 	unsigned int mTileHeight;
@@ -86,6 +185,9 @@ protected:
 	SceneNode* mParentNode;
 	
 private:
+    // maps a file and parses it in place into doc. file must outlive doc.
+    bool loadDocument(const std::string& path, MappedFile& file, pugi::xml_document& doc);
+    bool parseMapFile(const std::string& filename);
     bool parseMapNode(const pugi::xml_node& mapNode);
     bool parseTilesets(const pugi::xml_node& mapNode);
     bool parseLayer(const pugi::xml_node& layerNode);
@@ -95,31 +197,59 @@ private:
     bool processTiles(const pugi::xml_node& tilesetNode);
     
     //Reading the flipped bits
-    std::vector<unsigned char> intToBytes(sf::Uint32 paramInt);
-    std::pair<sf::Uint32, std::bitset<3> > resolveRotation(sf::Uint32 gid);
+    std::vector<unsigned char> intToBytes(sf::Uint32 paramInt) const;
+    std::pair<sf::Uint32, std::bitset<3> > resolveRotation(sf::Uint32 gid) const;
     
     //Image flip functions
-    void flipY(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3);
-    void flipX(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3);
-    void flipD(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3);
-    void doFlips(std::bitset<3> bits,sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3);
+    void flipY(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3) const;
+    void flipX(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3) const;
+    void flipD(sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3) const;
+    void doFlips(std::bitset<3> bits,sf::Vector2f *v0, sf::Vector2f *v1, sf::Vector2f *v2, sf::Vector2f *v3) const;
+    //returns the texture coords of a tile, flipped according to the flags in gid
+    std::array<sf::Vector2f, 4u> tileTexCoords(sf::Uint32 gid) const;
+    //fills vertices with the quad of the tile at grid position x, y and returns its tileset id
+    sf::Uint16 createTileVertices(float opacity, sf::Uint16 x, sf::Uint16 y, sf::Uint32 gid, const sf::Vector2f& offset, std::array<sf::Vertex, 4u>& vertices) const;
+    std::shared_ptr<LayerSet> createLayerSet(sf::Uint16 tilesetId) const;
     TileQuad* addTileToLayer(MapLayer& layer, sf::Uint16 x, sf::Uint16 y, sf::Uint32 gid, const sf::Vector2f& offset = sf::Vector2f());
     
-    void createDebugGrid();
-	//sets the visible area of tiles to be drawn
-	void setDrawingBounds(const sf::View& view);
-
     void drawLayer(sf::RenderTarget& rt, MapLayer& layer, bool debug = false);
+    // draws the debug shapes of the objects of a layer which are in view
+    void drawDebugObjects(sf::RenderTarget& rt, sf::Uint16 layer);
+    // creates the debug draw module the first time anything is debug drawn
+    tmx::DebugDraw& getDebugDraw();
+    std::unique_ptr<tmx::DebugDraw> mDebugDraw;
 	void draw(sf::RenderTarget& rt, sf::RenderStates states) const;
     
-    mutable sf::FloatRect mBounds; //bounding area of tiles visible on screen
-	mutable sf::Vector2f mLastViewPos; //save recalc bounds if view not moved
+    sf::FloatRect mBounds; //bounding area of tiles visible on screen
+	sf::Vector2f mLastViewPos; //save recalc bounds if view not moved
     
-	mutable std::vector<MapLayer> mLayers;
+	tmx::StringTable mStrings; // names and properties of objects and layers
+	std::vector<MapLayer> mLayers;
     std::map<std::string, std::string> mProperties;
     std::vector<std::unique_ptr<sf::Texture>> mImageLayerTextures;
     std::vector<std::unique_ptr<sf::Texture>> mTilesetTextures;
     const sf::Uint8 mPatchSize;
+    tmx::TileLayout mLayout;
+    
+    struct ImageSource // image file and transparency mask a texture was created from
+    {
+        std::string path;
+        bool masked;
+        sf::Color mask;
+        ImageSource();
+    };
+    std::vector<ImageSource> mTilesetImages; // one for each tileset texture
+    std::vector<ImageSource> mImageLayerImages; // one for each image layer texture
+    
+    // loads an image, applies its mask and pushes the created texture onto dest
+    bool loadTexture(const ImageSource& source, std::vector<std::unique_ptr<sf::Texture>>& dest);
+    
+    bool mAtlasEnabled;
+    tmx::AtlasLayout mAtlasLayout; // where each tileset image was placed, empty when not packed
+    // packs the tileset images into atlas textures and moves tile texture coords onto them
+    bool buildAtlas();
+    // creates the tileset textures from the tileset images arranged as described by layout
+    bool loadAtlasTextures(const tmx::AtlasLayout& layout);
     
     struct TileInfo // hold texture coords and tileset id of a tile
     {
@@ -130,21 +260,113 @@ private:
         TileInfo(const sf::IntRect& rect, const sf::Vector2f& size, sf::Uint16 tilesetId);
     };
     std::vector<TileInfo> mTileInfo; // stores information on all the tilesets for creating vertex arrays.
-    sf::VertexArray mGridVertices; //used to draw map grid in debug
+    std::map<sf::Uint32, std::map<std::string, std::string>> mTileProperties; // keyed by gid, only tiles with properties
+    
+    std::string mCollisionLayer;
+    std::string mCollisionProperty;
+    CollisionGrid mCollisionGrid;
+    sf::Int32 mCollisionLayerIndex; // layer the grid is built from, -1 when built from a tile property
+    std::vector<sf::Uint8> mSolidGids; // non zero for each gid with the collision property
+    
+    bool mCollisionObjects;
+    
+    // returns false if the map can't have a collision grid
+    bool buildCollisionGrid();
+    void createCollisionObjects();
+    // whether the tile at the given index of the map's tile layers is solid
+    bool isCollisionTile(std::size_t cell) const;
+    
+    struct AnimationFrame
+    {
+        sf::Uint32 gid;
+        sf::Uint32 duration; // milliseconds
+    };
+    struct AnimatedTile // a quad drawing an animated tile
+    {
+        TileQuad* quad;
+        sf::Uint32 gid; // including flip flags
+        // where the quad lives, used to relink it when loading from the cache
+        sf::Uint16 layer;
+        sf::Uint16 tileset;
+        sf::Uint32 quadIndex;
+    };
+    struct TileAnimation
+    {
+        std::vector<AnimationFrame> frames;
+        sf::Uint32 totalDuration;
+        sf::Uint32 currentFrame;
+        std::vector<AnimatedTile> tiles; // every quad showing this animation
+        TileAnimation();
+    };
+    std::map<sf::Uint32, TileAnimation> mAnimations; // keyed by the gid of the animated tile
+    sf::Time mAnimationTime; // all animations share one clock so every instance of a tile is in step
+    
+    void parseAnimations(const pugi::xml_node& tilesetNode, sf::Uint32 firstGid);
+    void parseTileProperties(const pugi::xml_node& tilesetNode, sf::Uint32 firstGid);
+    // adds or removes a quad from the tiles of the animation of gid, if it's animated
+    void trackAnimatedTile(TileQuad* quad, sf::Uint32 gid, sf::Uint16 layer, sf::Uint16 tileset, const LayerSet& set);
+    void untrackAnimatedTile(TileQuad* quad, sf::Uint32 gid);
+    // matches the quads of a tile layer's sets back up with the tiles they draw
+    void indexLayerQuads(MapLayer& layer);
+    // moves each animation to the frame for the current time, rewriting only the texture coords
+    // of the quads showing animations whose frame has changed
+    void updateAnimations(sf::Time dt);
     
     bool mQuadTreeAvailable;
     // root node for quad tree partition
     QuadTreeRoot mRootNode;
+    std::vector<MapObject*> mSweepCandidates; // reused by every sweep to avoid allocating
+    tmx::ObjectStore mObjectStore;
+    std::vector<sf::Uint32> mObjectIds; // reused by queries of the object store
+    
+    bool sweepObject(const sf::FloatRect& box, const sf::Vector2f& displacement, ObjectHit& hit);
     
     // Caches loaded images to prevent loading the same tileset more than once
     sf::Image& loadImage(const std::string& imageName);
     std::map<std::string, std::shared_ptr<sf::Image>> mCachedImages;
     bool mFailedImage;
     
-    bool decompress(const char* source, std::vector<unsigned char>& dest, int inSize, int expectedSize);
+    // files the current map was loaded from, used to detect a stale cache
+    std::vector<std::string> mDependencies;
+    bool mCacheEnabled;
+    
+    bool loadCache(const std::string& path);
+    bool readCacheLayer(CacheReader& reader);
+    void writeCache(const std::string& path) const;
+    void writeCacheLayer(CacheWriter& writer, const MapLayer& layer) const;
+    
+    struct ChunkState // residency of a streamed chunk
+    {
+        bool resident;
+        sf::Uint64 lastUsed; // streaming frame the chunk was last required on
+        std::size_t memory; // bytes of vertices held by the chunk
+        bool edited; // queued in mEditedChunks to be rebuilt
+        ChunkState();
+    };
+    bool mStreaming;
+    std::size_t mStreamBudget;
+    float mStreamLookAhead;
+    std::unique_ptr<ChunkStreamer> mStreamer;
+    std::vector<ChunkState> mChunks;
+    std::vector<sf::Uint32> mEditedChunks;
+    sf::Vector2u mChunkCount;
+    std::size_t mResidentMemory;
+    sf::Uint64 mStreamFrame;
+    sf::Vector2f mLastStreamCentre;
+    
+    bool mMergePatches;
+    
+    void startStreaming();
+    void stopStreaming();
+    // called on the loader thread. Only reads the gids, opacity and tile info, which don't change while streaming.
+    void buildChunk(MapChunk& chunk) const;
+    void addChunk(MapChunk& chunk);
+    void evictChunk(sf::Uint32 index);
+    
+    // decompresses zlib, gzip or zstd layer data directly into dest, which must already be sized
+    // to the number of tiles in the layer. Fails if the data does not exactly fill dest, or if any
+    // input is left over once the stream ends.
+    bool decompress(const unsigned char* source, std::size_t inSize, std::vector<sf::Uint32>& dest, const std::string& compression);
     std::string fileFromPath(const std::string& path);
     sf::Color colorFromHex(const char* hexStr) const;
-};
-
-//method for decoding base64 encoded strings
-static std::string base64Decode(std::string const& string);
\ No newline at end of file
+};
\ No newline at end of file
@@ -24,6 +24,7 @@ World::World(sf::RenderTarget& outputTarget, FontHolder& fonts, SoundPlayer& sou
  , mTextures()
  , mSceneGraph()
  , mSceneLayers()
+ , mRenderQueue()
  , mWorldBounds(0.f, 0.f, mWorldView.getSize().x, 2000.0f)
  , mSpawnPosition(mWorldView.getSize().x / 2.f, mWorldBounds.height - mWorldView.getSize().y / 2.f)
  , mScrollSpeed(-50.f)
@@ -77,18 +78,25 @@ void World::update(sf::Time dt)
 
 void World::draw()
 {
+    // record the scene so sprites sharing a texture are drawn in batches,
+    // skipping anything outside the view
+    mRenderQueue.clear();
+    mRenderQueue.setCullRect(getViewBounds());
+    mSceneGraph.updateBounds();
+    mSceneGraph.record(mRenderQueue, sf::RenderStates::Default);
+    
     if(mPostEffectsSupported)
 	{
 	    mSceneTexture.clear();
 		mSceneTexture.setView(mWorldView);
-		mSceneTexture.draw(mSceneGraph);
+		mRenderQueue.submit(mSceneTexture);
 		mSceneTexture.display();
 		mBloomEffect.apply(mSceneTexture, mTarget);
 	}
 	else
 	{
         mTarget.setView(mWorldView);
-	    mTarget.draw(mSceneGraph);
+	    mRenderQueue.submit(mTarget);
 	}
 }
 
@@ -221,6 +229,7 @@ void World::buildScene()
 	    unsigned int category = (i == LowerAir) ? Category::SceneAirLayer : Category::None;
 		
 		SceneNode::Ptr layer(new SceneNode(category));
+		layer->setDrawLayer(i);
 		mSceneLayers[i] = layer.get();
 		
 		mSceneGraph.attachChild(std::move(layer));
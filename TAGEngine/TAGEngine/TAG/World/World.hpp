@@ -9,6 +9,7 @@
 #include "Command.hpp"
 #include "BloomEffect.hpp"
 #include "SoundPlayer.hpp"
+#include "RenderQueue.hpp"
 
 #include <SFML/System/NonCopyable.hpp>
 #include <SFML/Graphics/View.hpp>
@@ -81,6 +82,7 @@ private:
 	
 	SceneNode			mSceneGraph;
 	std::array<SceneNode*, LayerCount> mSceneLayers;
+	RenderQueue			mRenderQueue;
 	
 	CommandQueue		mCommandQueue;
 	